@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string_view>
+
+// Запись прямого индекса: слово документа (по id в словаре сервера) и сколько раз оно встретилось.
+// Записи документа лежат подряд в общем пуле, отсортированы по term_id.
+struct ForwardIndexEntry {
+    uint32_t term_id;
+    uint32_t count;
+};
+
+struct WordFrequency {
+    std::string_view word;
+    double frequency;
+};
+
+// Лёгкое представление записей одного документа без копирования.
+// Действительно до следующего AddDocument/RemoveDocument.
+class WordFrequenciesView {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = WordFrequency;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = WordFrequency;
+
+        const_iterator() = default;
+
+        const_iterator(const ForwardIndexEntry *entry, const std::string_view *term_words, uint32_t word_count)
+            : entry_(entry), term_words_(term_words), word_count_(word_count) {
+        }
+
+        WordFrequency operator*() const {
+            return MakeWordFrequency(*entry_, term_words_, word_count_);
+        }
+
+        const_iterator &operator++() {
+            ++entry_;
+            return *this;
+        }
+
+        const_iterator operator++(int) {
+            const_iterator result = *this;
+            ++entry_;
+            return result;
+        }
+
+        bool operator==(const const_iterator &other) const {
+            return entry_ == other.entry_;
+        }
+
+        bool operator!=(const const_iterator &other) const {
+            return entry_ != other.entry_;
+        }
+
+    private:
+        const ForwardIndexEntry *entry_ = nullptr;
+        const std::string_view *term_words_ = nullptr;
+        uint32_t word_count_ = 0;
+    };
+
+    WordFrequenciesView() = default;
+
+    WordFrequenciesView(const ForwardIndexEntry *begin, const ForwardIndexEntry *end, const std::string_view *term_words,
+                        uint32_t word_count)
+        : begin_(begin), end_(end), term_words_(term_words), word_count_(word_count) {
+    }
+
+    const_iterator begin() const {
+        return {begin_, term_words_, word_count_};
+    }
+
+    const_iterator end() const {
+        return {end_, term_words_, word_count_};
+    }
+
+    std::size_t size() const {
+        return static_cast<std::size_t>(end_ - begin_);
+    }
+
+    bool empty() const {
+        return begin_ == end_;
+    }
+
+    // линейный поиск: документы короткие, а словаря "слово -> term_id" у представления нет
+    double at(std::string_view word) const {
+        for (const ForwardIndexEntry *entry = begin_; entry != end_; ++entry) {
+            if (term_words_[entry->term_id] == word) {
+                return MakeWordFrequency(*entry, term_words_, word_count_).frequency;
+            }
+        }
+        throw std::out_of_range("Word is not in the document");
+    }
+
+private:
+    const ForwardIndexEntry *begin_ = nullptr;
+    const ForwardIndexEntry *end_ = nullptr;
+    const std::string_view *term_words_ = nullptr;
+    uint32_t word_count_ = 0;
+
+    static WordFrequency MakeWordFrequency(const ForwardIndexEntry &entry, const std::string_view *term_words,
+                                           uint32_t word_count) {
+        return {term_words[entry.term_id], static_cast<double>(entry.count) / static_cast<double>(word_count)};
+    }
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+class LatencyStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    void Add(Clock::duration latency) {
+        latencies_.push_back(latency);
+        is_sorted_ = false;
+    }
+
+    void Merge(const LatencyStats& other) {
+        latencies_.insert(latencies_.end(), other.latencies_.begin(), other.latencies_.end());
+        is_sorted_ = false;
+    }
+
+    std::size_t GetCount() const {
+        return latencies_.size();
+    }
+
+    // percentile в диапазоне [0, 100]
+    Clock::duration GetPercentile(double percentile) {
+        if (latencies_.empty()) {
+            return Clock::duration::zero();
+        }
+        if (!is_sorted_) {
+            std::sort(latencies_.begin(), latencies_.end());
+            is_sorted_ = true;
+        }
+        const double rank = percentile / 100.0 * static_cast<double>(latencies_.size() - 1);
+        return latencies_[static_cast<std::size_t>(rank + 0.5)];
+    }
+
+    Clock::duration GetMean() const {
+        if (latencies_.empty()) {
+            return Clock::duration::zero();
+        }
+        Clock::duration total = Clock::duration::zero();
+        for (Clock::duration latency : latencies_) {
+            total += latency;
+        }
+        return total / static_cast<Clock::rep>(latencies_.size());
+    }
+
+    void Report(std::ostream& out, const std::string& id) {
+        using namespace std::literals;
+        out << id << ": count = "s << GetCount()
+            << ", mean = "s << ToMicroseconds(GetMean()) << " us"s
+            << ", p50 = "s << ToMicroseconds(GetPercentile(50)) << " us"s
+            << ", p90 = "s << ToMicroseconds(GetPercentile(90)) << " us"s
+            << ", p99 = "s << ToMicroseconds(GetPercentile(99)) << " us"s
+            << ", p99.9 = "s << ToMicroseconds(GetPercentile(99.9)) << " us"s
+            << ", max = "s << ToMicroseconds(GetPercentile(100)) << " us"s << std::endl;
+    }
+
+private:
+    std::vector<Clock::duration> latencies_;
+    bool is_sorted_ = true;
+
+    static long long ToMicroseconds(Clock::duration duration) {
+        return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+    }
+};
@@ -1,5 +1,6 @@
 #include "search_server.h"
 #include "log_duration.h"
+#include "test_example_functions.h"
 #include <execution>
 #include <iostream>
 #include <random>
@@ -47,7 +48,7 @@ vector<string> GenerateQueries(mt19937& generator, const vector<string>& diction
 }
 template <typename ExecutionPolicy>
 void Test(string_view mark, const SearchServer& search_server, const vector<string>& queries, ExecutionPolicy&& policy) {
-    LOG_DURATION(mark);
+    LOG_DURATION_STREAM(string(mark), cerr);
     double total_relevance = 0;
     for (const string_view query : queries) {
         for (const auto& document : search_server.FindTopDocuments(policy, query)) {
@@ -58,6 +59,8 @@ void Test(string_view mark, const SearchServer& search_server, const vector<stri
 }
 #define TEST(policy) Test(#policy, search_server, queries, execution::policy)
 int main() {
+    TestSearchServer();
+
     mt19937 generator;
     const auto dictionary = GenerateDictionary(generator, 1000, 10);
     const auto documents = GenerateQueries(generator, dictionary, 10'000, 70);
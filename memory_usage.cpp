@@ -0,0 +1,25 @@
+#include "memory_usage.h"
+
+using namespace std;
+
+size_t MemoryUsage::GetTotal() const {
+    return all_words + word_to_document_freqs + document_to_word_freqs + documents + document_ids + stop_words + impacts
+           + champion_lists;
+}
+
+ostream &operator<<(ostream &out, const MemoryUsage &usage) {
+    out << "{ total = "s << usage.GetTotal()
+        << ", all_words = "s << usage.all_words
+        << ", word_to_document_freqs = "s << usage.word_to_document_freqs
+        << ", document_to_word_freqs = "s << usage.document_to_word_freqs
+        << ", documents = "s << usage.documents
+        << ", document_ids = "s << usage.document_ids
+        << ", stop_words = "s << usage.stop_words
+        << ", impacts = "s << usage.impacts
+        << ", champion_lists = "s << usage.champion_lists
+        << ", terms = "s << usage.term_count
+        << ", postings = "s << usage.posting_count
+        << ", document_count = "s << usage.document_count
+        << (usage.is_exact ? ", exact }"s : ", estimated }"s);
+    return out;
+}
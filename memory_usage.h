@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Структуры индекса SearchServer, по которым ведётся учёт памяти
+enum class IndexStructure {
+    ALL_WORDS,
+    WORD_TO_DOCUMENT_FREQS,
+    DOCUMENT_TO_WORD_FREQS,
+    DOCUMENTS,
+    DOCUMENT_IDS,
+    STOP_WORDS,
+    IMPACTS,
+    CHAMPIONS,
+    COUNT,
+};
+
+struct MemoryUsage {
+    // байты по структурам, включая накладные расходы узлов и аллокатора
+    size_t all_words = 0;
+    size_t word_to_document_freqs = 0;
+    size_t document_to_word_freqs = 0;
+    size_t documents = 0;
+    size_t document_ids = 0;
+    size_t stop_words = 0;
+    // вклады SearchServer::PrecomputeImpacts, если посчитаны
+    size_t impacts = 0;
+    // списки чемпионов частых слов
+    size_t champion_lists = 0;
+
+    size_t term_count = 0;
+    size_t posting_count = 0;
+    size_t document_count = 0;
+
+    // true - байты посчитаны CountingAllocator (без накладных расходов malloc), false - оценка
+    bool is_exact = false;
+
+    size_t GetTotal() const;
+};
+
+std::ostream &operator<<(std::ostream &out, const MemoryUsage &usage);
+
+//----------------------------------------------------------------------------------------------------------------------
+// Оценки для libstdc++ и glibc malloc: узел красно-чёрного дерева - цвет и три указателя перед значением,
+// блок malloc - плюс 8 байт заголовка, выравнивание на 16, не меньше 32 байт.
+constexpr size_t TREE_NODE_HEADER_SIZE = 4 * sizeof(void *);
+constexpr size_t STRING_LOCAL_CAPACITY = 15;
+
+constexpr size_t EstimateAllocationSize(size_t bytes) {
+    return bytes == 0 ? 0 : std::max<size_t>(32, (bytes + 8 + 15) / 16 * 16);
+}
+
+template<typename Value>
+constexpr size_t EstimateTreeNodeSize() {
+    return EstimateAllocationSize(TREE_NODE_HEADER_SIZE + sizeof(Value));
+}
+
+template<typename String>
+size_t EstimateStringHeapSize(const String &str) {
+    return str.capacity() > STRING_LOCAL_CAPACITY ? EstimateAllocationSize(str.capacity() + 1) : 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+// Точный учёт для бенчмарков: при SEARCH_SERVER_COUNT_ALLOCATIONS контейнеры индекса выделяют память
+// через CountingAllocator. Счётчики общие на процесс, поэтому точны, когда в процессе один сервер.
+inline std::atomic<int64_t> allocated_index_bytes[static_cast<size_t>(IndexStructure::COUNT)] = {};
+
+template<typename T, IndexStructure Structure>
+struct CountingAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind {
+        using other = CountingAllocator<U, Structure>;
+    };
+
+    CountingAllocator() noexcept = default;
+
+    template<typename U>
+    CountingAllocator(const CountingAllocator<U, Structure> &) noexcept {
+    }
+
+    T *allocate(size_t n) {
+        T *result = std::allocator<T>().allocate(n);
+        allocated_index_bytes[static_cast<size_t>(Structure)].fetch_add(n * sizeof(T), std::memory_order_relaxed);
+        return result;
+    }
+
+    void deallocate(T *p, size_t n) noexcept {
+        allocated_index_bytes[static_cast<size_t>(Structure)].fetch_sub(n * sizeof(T), std::memory_order_relaxed);
+        std::allocator<T>().deallocate(p, n);
+    }
+
+    template<typename U>
+    bool operator==(const CountingAllocator<U, Structure> &) const noexcept {
+        return true;
+    }
+
+    template<typename U>
+    bool operator!=(const CountingAllocator<U, Structure> &) const noexcept {
+        return false;
+    }
+};
+
+inline size_t GetAllocatedIndexBytes(IndexStructure structure) {
+    return static_cast<size_t>(allocated_index_bytes[static_cast<size_t>(structure)].load(std::memory_order_relaxed));
+}
+
+#ifdef SEARCH_SERVER_COUNT_ALLOCATIONS
+template<typename T, IndexStructure Structure>
+using IndexAllocator = CountingAllocator<T, Structure>;
+#else
+template<typename T, IndexStructure Structure>
+using IndexAllocator = std::allocator<T>;
+#endif
+
+template<typename Key, typename Value, IndexStructure Structure, typename Compare = std::less<Key>>
+using IndexMap = std::map<Key, Value, Compare, IndexAllocator<std::pair<const Key, Value>, Structure>>;
+
+template<typename Key, IndexStructure Structure, typename Compare = std::less<Key>>
+using IndexSet = std::set<Key, Compare, IndexAllocator<Key, Structure>>;
+
+template<IndexStructure Structure>
+using IndexString = std::basic_string<char, std::char_traits<char>, IndexAllocator<char, Structure>>;
+
+template<typename T, IndexStructure Structure>
+using IndexVector = std::vector<T, IndexAllocator<T, Structure>>;
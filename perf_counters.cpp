@@ -0,0 +1,174 @@
+#include "perf_counters.h"
+
+#include <deque>
+#include <mutex>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace {
+
+#ifdef __linux__
+// Счётчики одного потока, открытые одной группой: читаются одним вызовом read
+class PerfCounterGroup {
+public:
+    PerfCounterGroup() {
+        const uint64_t configs[] = {
+                PERF_COUNT_HW_INSTRUCTIONS,
+                PERF_COUNT_HW_CPU_CYCLES,
+                PERF_COUNT_HW_CACHE_MISSES,
+                PERF_COUNT_HW_BRANCH_MISSES,
+        };
+        for (size_t counter = 0; counter < static_cast<size_t>(PerfCounter::COUNT); ++counter) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[counter];
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            // без ядра и гипервизора: так счётчики доступны и при perf_event_paranoid = 2
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            const int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, leader_fd_, 0));
+            if (fd < 0) {
+                continue;
+            }
+            if (leader_fd_ < 0) {
+                leader_fd_ = fd;
+            } else {
+                member_fds_.push_back(fd);
+            }
+            counters_.push_back(counter);
+        }
+    }
+
+    PerfCounterGroup(const PerfCounterGroup &) = delete;
+
+    PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+
+    ~PerfCounterGroup() {
+        for (int fd : member_fds_) {
+            close(fd);
+        }
+        if (leader_fd_ >= 0) {
+            close(leader_fd_);
+        }
+    }
+
+    PerfCounterValues Read() const {
+        PerfCounterValues result;
+        if (leader_fd_ < 0) {
+            return result;
+        }
+        struct {
+            uint64_t count;
+            uint64_t time_enabled;
+            uint64_t time_running;
+            uint64_t values[static_cast<size_t>(PerfCounter::COUNT)];
+        } data{};
+        if (read(leader_fd_, &data, sizeof(data)) <= 0 || data.time_running == 0) {
+            return result;
+        }
+        // если счётчиков больше, чем регистров, ядро их чередует: досчитываем до полного времени
+        const double scale = static_cast<double>(data.time_enabled) / static_cast<double>(data.time_running);
+        for (size_t i = 0; i < counters_.size() && i < data.count; ++i) {
+            result.values[counters_[i]] = static_cast<uint64_t>(static_cast<double>(data.values[i]) * scale);
+            result.is_available[counters_[i]] = true;
+        }
+        return result;
+    }
+
+private:
+    int leader_fd_ = -1;
+    vector<int> member_fds_;
+    // какой PerfCounter на каком месте в группе
+    vector<size_t> counters_;
+};
+#endif
+
+const char *const COUNTER_NAMES[] = {"instructions", "cycles", "LLC misses", "branch misses"};
+
+struct PerfScopeRegistry {
+    mutex scopes_mutex;
+    deque<PerfScopeStats> scopes;
+};
+
+PerfScopeRegistry &GetPerfScopeRegistry() {
+    static PerfScopeRegistry registry;
+    return registry;
+}
+
+} // namespace
+
+PerfCounterValues ReadPerfCounters() {
+#ifdef __linux__
+    thread_local const PerfCounterGroup group;
+    return group.Read();
+#else
+    return {};
+#endif
+}
+
+void PerfScopeStats::Add(chrono::steady_clock::duration duration, const PerfCounterValues &begin,
+                         const PerfCounterValues &end) {
+    call_count_.fetch_add(1, memory_order_relaxed);
+    total_nanoseconds_.fetch_add(static_cast<uint64_t>(chrono::duration_cast<chrono::nanoseconds>(duration).count()),
+                                 memory_order_relaxed);
+    for (size_t counter = 0; counter < static_cast<size_t>(PerfCounter::COUNT); ++counter) {
+        if (begin.is_available[counter] && end.is_available[counter] && end.values[counter] >= begin.values[counter]) {
+            totals_[counter].fetch_add(end.values[counter] - begin.values[counter], memory_order_relaxed);
+            counted_calls_[counter].fetch_add(1, memory_order_relaxed);
+        }
+    }
+}
+
+void PerfScopeStats::Report(ostream &out) const {
+    const uint64_t call_count = call_count_.load(memory_order_relaxed);
+    out << name_ << ": calls = "s << call_count;
+    if (call_count == 0) {
+        out << '\n';
+        return;
+    }
+    out << ", mean = "s << total_nanoseconds_.load(memory_order_relaxed) / call_count << " ns"s;
+
+    double means[static_cast<size_t>(PerfCounter::COUNT)] = {};
+    for (size_t counter = 0; counter < static_cast<size_t>(PerfCounter::COUNT); ++counter) {
+        const uint64_t counted_calls = counted_calls_[counter].load(memory_order_relaxed);
+        out << ", "s << COUNTER_NAMES[counter] << " = "s;
+        if (counted_calls == 0) {
+            out << "n/a"s;
+            continue;
+        }
+        means[counter] = static_cast<double>(totals_[counter].load(memory_order_relaxed)) / static_cast<double>(counted_calls);
+        out << means[counter];
+    }
+    const double cycles = means[static_cast<size_t>(PerfCounter::CYCLES)];
+    if (cycles > 0) {
+        out << ", IPC = "s << means[static_cast<size_t>(PerfCounter::INSTRUCTIONS)] / cycles;
+    }
+    out << '\n';
+}
+
+PerfScopeStats &RegisterPerfScope(const string &name) {
+    PerfScopeRegistry &registry = GetPerfScopeRegistry();
+    lock_guard guard(registry.scopes_mutex);
+    for (PerfScopeStats &scope : registry.scopes) {
+        if (scope.GetName() == name) {
+            return scope;
+        }
+    }
+    return registry.scopes.emplace_back(name);
+}
+
+void ReportPerfScopes(ostream &out) {
+    PerfScopeRegistry &registry = GetPerfScopeRegistry();
+    lock_guard guard(registry.scopes_mutex);
+    for (const PerfScopeStats &scope : registry.scopes) {
+        scope.Report(out);
+    }
+}
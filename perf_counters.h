@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <utility>
+
+// Аппаратные счётчики (Linux perf_event_open) для участков кода. Включаются при сборке с
+// SEARCH_SERVER_PERF_COUNTERS, иначе PERF_SCOPE ничего не делает:
+//   PERF_SCOPE("SearchServer::AddDocument");
+// Счётчики открываются для каждого потока отдельно. Если ядро их не даёт (контейнер, perf_event_paranoid,
+// виртуальная машина), участки считают только вызовы и время, а в отчёте вместо счётчиков - n/a.
+
+enum class PerfCounter {
+    INSTRUCTIONS,
+    CYCLES,
+    LLC_MISSES,
+    BRANCH_MISSES,
+    COUNT,
+};
+
+struct PerfCounterValues {
+    uint64_t values[static_cast<size_t>(PerfCounter::COUNT)] = {};
+    // какие счётчики удалось открыть
+    bool is_available[static_cast<size_t>(PerfCounter::COUNT)] = {};
+};
+
+// Текущие значения счётчиков потока (с поправкой на мультиплексирование)
+PerfCounterValues ReadPerfCounters();
+
+// Накопленные значения одного участка; обновляются из разных потоков
+class PerfScopeStats {
+public:
+    explicit PerfScopeStats(std::string name) : name_(std::move(name)) {
+    }
+
+    const std::string &GetName() const {
+        return name_;
+    }
+
+    void Add(std::chrono::steady_clock::duration duration, const PerfCounterValues &begin, const PerfCounterValues &end);
+
+    // Средние на вызов
+    void Report(std::ostream &out) const;
+
+private:
+    const std::string name_;
+    std::atomic<uint64_t> call_count_ = 0;
+    std::atomic<uint64_t> total_nanoseconds_ = 0;
+    std::atomic<uint64_t> totals_[static_cast<size_t>(PerfCounter::COUNT)] = {};
+    std::atomic<uint64_t> counted_calls_[static_cast<size_t>(PerfCounter::COUNT)] = {};
+};
+
+// Статистика участка с таким именем; живёт до конца программы
+PerfScopeStats &RegisterPerfScope(const std::string &name);
+
+// Средние по всем участкам, в порядке регистрации; ничего не пишет, если участков нет
+void ReportPerfScopes(std::ostream &out);
+
+class PerfScope {
+public:
+    explicit PerfScope(PerfScopeStats &stats) : stats_(stats), begin_(ReadPerfCounters()) {
+    }
+
+    PerfScope(const PerfScope &) = delete;
+
+    PerfScope &operator=(const PerfScope &) = delete;
+
+    ~PerfScope() {
+        const PerfCounterValues end = ReadPerfCounters();
+        stats_.Add(std::chrono::steady_clock::now() - start_time_, begin_, end);
+    }
+
+private:
+    PerfScopeStats &stats_;
+    const std::chrono::steady_clock::time_point start_time_ = std::chrono::steady_clock::now();
+    const PerfCounterValues begin_;
+};
+
+#define PERF_CONCAT_INTERNAL(X, Y) X##Y
+#define PERF_CONCAT(X, Y) PERF_CONCAT_INTERNAL(X, Y)
+
+#ifdef SEARCH_SERVER_PERF_COUNTERS
+#define PERF_SCOPE(name) \
+    static PerfScopeStats &PERF_CONCAT(perfScopeStats, __LINE__) = RegisterPerfScope(name); \
+    PerfScope PERF_CONCAT(perfScope, __LINE__)(PERF_CONCAT(perfScopeStats, __LINE__))
+#else
+#define PERF_SCOPE(name)
+#endif
@@ -0,0 +1,143 @@
+#include "query_log.h"
+
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+namespace {
+
+constexpr string_view QUERY_LOG_MAGIC = "SSQLOG"sv;
+constexpr uint8_t QUERY_LOG_VERSION = 1;
+constexpr size_t FILTER_KIND_BITS = 4;
+// длиннее запросов не бывает; большая длина - признак испорченного журнала
+constexpr uint64_t MAX_QUERY_SIZE = 1 << 24;
+
+void AppendVarint(string& buffer, uint64_t value) {
+    while (value >= 0x80) {
+        buffer.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.push_back(static_cast<char>(value));
+}
+
+// false - поток закончился до первого байта
+bool ReadVarint(istream& input, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        const int byte = input.get();
+        if (byte == istream::traits_type::eof()) {
+            if (shift == 0) {
+                return false;
+            }
+            throw runtime_error("Query log is truncated"s);
+        }
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    throw runtime_error("Query log is corrupted"s);
+}
+
+} // namespace
+
+//----------------------------------------------------------------------------------------------------------------------
+QueryLogWriter::QueryLogWriter(ostream& output) : output_(output), last_time_(Clock::now()) {
+    const auto start_time = chrono::duration_cast<chrono::microseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+    string header(QUERY_LOG_MAGIC);
+    header.push_back(static_cast<char>(QUERY_LOG_VERSION));
+    header.push_back('\0');
+    for (int i = 0; i < 8; ++i) {
+        header.push_back(static_cast<char>(static_cast<uint64_t>(start_time) >> (8 * i)));
+    }
+    output_.write(header.data(), static_cast<streamsize>(header.size()));
+}
+
+void QueryLogWriter::Write(string_view query, QueryFilterKind filter_kind, DocumentStatus status) {
+    lock_guard lock(mutex_);
+    // время берётся под мьютексом, чтобы интервалы между записями не были отрицательными
+    const Clock::time_point now = Clock::now();
+    buffer_.clear();
+    AppendVarint(buffer_, chrono::duration_cast<chrono::microseconds>(now - last_time_).count());
+    buffer_.push_back(static_cast<char>(static_cast<uint8_t>(filter_kind)
+                                        | static_cast<uint8_t>(status) << FILTER_KIND_BITS));
+    AppendVarint(buffer_, query.size());
+    buffer_.append(query);
+    output_.write(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+    // микросекунды, не попавшие в интервал, переходят в следующий
+    last_time_ += chrono::duration_cast<chrono::microseconds>(now - last_time_);
+    ++record_count_;
+}
+
+void QueryLogWriter::Flush() {
+    lock_guard lock(mutex_);
+    output_.flush();
+}
+
+size_t QueryLogWriter::GetRecordCount() const {
+    lock_guard lock(mutex_);
+    return record_count_;
+}
+//----------------------------------------------------------------------------------------------------------------------
+QueryLogReader::QueryLogReader(istream& input) : input_(input) {
+    char header[QUERY_LOG_MAGIC.size() + 2 + 8];
+    input_.read(header, sizeof(header));
+    if (input_.gcount() != static_cast<streamsize>(sizeof(header))
+        || string_view(header, QUERY_LOG_MAGIC.size()) != QUERY_LOG_MAGIC) {
+        throw runtime_error("Not a query log"s);
+    }
+    if (static_cast<uint8_t>(header[QUERY_LOG_MAGIC.size()]) != QUERY_LOG_VERSION) {
+        throw runtime_error("Unsupported query log version"s);
+    }
+    uint64_t start_time = 0;
+    for (int i = 0; i < 8; ++i) {
+        start_time |= static_cast<uint64_t>(static_cast<uint8_t>(header[QUERY_LOG_MAGIC.size() + 2 + i])) << (8 * i);
+    }
+    start_time_ = chrono::system_clock::time_point(
+            chrono::duration_cast<chrono::system_clock::duration>(chrono::microseconds(start_time)));
+}
+
+chrono::system_clock::time_point QueryLogReader::GetStartTime() const {
+    return start_time_;
+}
+
+bool QueryLogReader::Read(QueryLogRecord& record) {
+    uint64_t interval;
+    if (!ReadVarint(input_, interval)) {
+        return false;
+    }
+    const int filter = input_.get();
+    uint64_t query_size;
+    if (filter == istream::traits_type::eof() || !ReadVarint(input_, query_size)) {
+        throw runtime_error("Query log is truncated"s);
+    }
+    const uint8_t filter_kind = static_cast<uint8_t>(filter) & ((1 << FILTER_KIND_BITS) - 1);
+    const uint8_t status = static_cast<uint8_t>(filter) >> FILTER_KIND_BITS;
+    if (filter_kind > static_cast<uint8_t>(QueryFilterKind::PREDICATE)
+        || status > static_cast<uint8_t>(DocumentStatus::REMOVED) || query_size > MAX_QUERY_SIZE) {
+        throw runtime_error("Query log is corrupted"s);
+    }
+
+    record.query.resize(query_size);
+    input_.read(record.query.data(), static_cast<streamsize>(query_size));
+    if (input_.gcount() != static_cast<streamsize>(query_size)) {
+        throw runtime_error("Query log is truncated"s);
+    }
+    time_ += chrono::microseconds(interval);
+    record.time = time_;
+    record.filter_kind = static_cast<QueryFilterKind>(filter_kind);
+    record.status = static_cast<DocumentStatus>(status);
+    return true;
+}
+//----------------------------------------------------------------------------------------------------------------------
+vector<QueryLogRecord> ReadQueryLog(istream& input) {
+    QueryLogReader reader(input);
+    vector<QueryLogRecord> records;
+    QueryLogRecord record;
+    while (reader.Read(record)) {
+        records.push_back(move(record));
+    }
+    return records;
+}
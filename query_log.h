@@ -0,0 +1,71 @@
+#pragma once
+
+#include "document.h"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Двоичный журнал запросов для воспроизведения нагрузки (query_replay).
+// Формат: заголовок - "SSQLOG", версия, резервный байт, время начала журнала (мкс с эпохи, 8 байт little-endian);
+// затем записи: varint - мкс от предыдущей записи, байт - вид фильтра и статус, varint - длина запроса, запрос.
+
+// Каким вариантом FindTopDocuments выполнен запрос
+enum class QueryFilterKind : uint8_t {
+    DEFAULT,
+    STATUS,
+    // сам предикат не сохраняется
+    PREDICATE,
+};
+
+struct QueryLogRecord {
+    // от начала журнала
+    std::chrono::microseconds time = std::chrono::microseconds::zero();
+    QueryFilterKind filter_kind = QueryFilterKind::DEFAULT;
+    DocumentStatus status = DocumentStatus::ACTUAL;
+    std::string query;
+};
+
+// Пишет запросы с отметкой времени поступления; можно вызывать из нескольких потоков
+class QueryLogWriter {
+public:
+    explicit QueryLogWriter(std::ostream& output);
+
+    void Write(std::string_view query, QueryFilterKind filter_kind, DocumentStatus status = DocumentStatus::ACTUAL);
+
+    void Flush();
+
+    std::size_t GetRecordCount() const;
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::ostream& output_;
+    mutable std::mutex mutex_;
+    Clock::time_point last_time_;
+    std::string buffer_;
+    std::size_t record_count_ = 0;
+};
+
+class QueryLogReader {
+public:
+    // Бросает runtime_error, если поток не начинается с заголовка журнала
+    explicit QueryLogReader(std::istream& input);
+
+    std::chrono::system_clock::time_point GetStartTime() const;
+
+    // false - журнал закончился; обрезанная запись - runtime_error
+    bool Read(QueryLogRecord& record);
+
+private:
+    std::istream& input_;
+    std::chrono::system_clock::time_point start_time_;
+    std::chrono::microseconds time_ = std::chrono::microseconds::zero();
+};
+
+std::vector<QueryLogRecord> ReadQueryLog(std::istream& input);
@@ -0,0 +1,152 @@
+#include "query_replay.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------------------------
+void QueryReplayStats::Report(ostream& out) {
+    const double seconds = chrono::duration<double>(elapsed).count();
+    out << "Queries: "s << query_count << ", errors: "s << error_count
+        << ", elapsed: "s << chrono::duration_cast<chrono::milliseconds>(elapsed).count() << " ms"s
+        << ", throughput: "s << (seconds > 0 ? static_cast<double>(query_count) / seconds : 0.0) << " qps"s;
+    if (offered_rate > 0) {
+        out << ", offered: "s << offered_rate << " qps"s;
+    }
+    out << endl;
+    latencies.Report(out, "Query latency"s);
+    if (offered_rate > 0) {
+        service_times.Report(out, "Service time"s);
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+namespace {
+
+struct ReplayWorkerStats {
+    LatencyStats latencies;
+    LatencyStats service_times;
+    size_t error_count = 0;
+};
+
+class ReplaySchedule {
+public:
+    ReplaySchedule(const vector<QueryLogRecord>& records, const QueryReplayOptions& options)
+        : records_(records), mode_(options.mode), rate_(options.rate), speed_(options.speed) {
+        if (records_.size() > 1) {
+            const auto span = records_.back().time - records_.front().time;
+            // следующий проход начинается через средний интервал после последнего запроса
+            pass_duration_ = span + span / static_cast<long long>(records_.size() - 1);
+        }
+    }
+
+    // Когда отправить index-й запрос (с учётом повторов), от начала воспроизведения
+    LatencyStats::Clock::duration GetSendTime(size_t index) const {
+        chrono::duration<double> time = chrono::duration<double>::zero();
+        if (mode_ == QueryReplayMode::FIXED_RATE) {
+            time = chrono::duration<double>(static_cast<double>(index) / rate_);
+        } else if (mode_ == QueryReplayMode::RECORDED) {
+            const size_t pass = index / records_.size();
+            const auto recorded_time = records_[index % records_.size()].time - records_.front().time
+                                       + pass_duration_ * static_cast<long long>(pass);
+            time = chrono::duration<double>(recorded_time) / speed_;
+        }
+        return chrono::duration_cast<LatencyStats::Clock::duration>(time);
+    }
+
+    // Средняя частота отправки
+    double GetOfferedRate() const {
+        if (mode_ == QueryReplayMode::FIXED_RATE) {
+            return rate_;
+        }
+        if (mode_ == QueryReplayMode::RECORDED && pass_duration_ > chrono::microseconds::zero()) {
+            return static_cast<double>(records_.size()) / chrono::duration<double>(pass_duration_).count() * speed_;
+        }
+        return 0.0;
+    }
+
+private:
+    const vector<QueryLogRecord>& records_;
+    const QueryReplayMode mode_;
+    const double rate_;
+    const double speed_;
+    chrono::microseconds pass_duration_ = chrono::microseconds::zero();
+};
+
+void ExecuteQuery(const SearchServer& search_server, SearchServer::QueryContext& context,
+                  const QueryLogRecord& record) {
+    switch (record.filter_kind) {
+        case QueryFilterKind::DEFAULT:
+            search_server.FindTopDocuments(context, record.query);
+            break;
+        case QueryFilterKind::STATUS:
+            search_server.FindTopDocuments(context, record.query, record.status);
+            break;
+        case QueryFilterKind::PREDICATE:
+            search_server.FindTopDocuments(context, record.query, [](int, DocumentStatus, int) {
+                return true;
+            });
+            break;
+    }
+}
+
+} // namespace
+
+QueryReplayStats ReplayQueries(const SearchServer& search_server, const vector<QueryLogRecord>& records,
+                               const QueryReplayOptions& options) {
+    if (options.mode == QueryReplayMode::FIXED_RATE && !(options.rate > 0)) {
+        throw invalid_argument("Replay rate must be positive"s);
+    }
+    if (options.mode == QueryReplayMode::RECORDED && !(options.speed > 0)) {
+        throw invalid_argument("Replay speed must be positive"s);
+    }
+
+    QueryReplayStats stats;
+    const size_t query_count = records.empty() ? 0 : records.size() * options.repeat;
+    const ReplaySchedule schedule(records, options);
+    const bool is_open_loop = options.mode != QueryReplayMode::CLOSED_LOOP;
+
+    vector<ReplayWorkerStats> worker_stats(max<size_t>(options.thread_count, 1));
+    atomic<size_t> next_index = 0;
+    const auto start_time = LatencyStats::Clock::now();
+    vector<thread> workers;
+    for (ReplayWorkerStats& worker : worker_stats) {
+        workers.emplace_back([&] {
+            SearchServer::QueryContext context;
+            for (size_t index = next_index++; index < query_count; index = next_index++) {
+                // в открытом цикле запрос, для которого не нашлось свободного потока, ждёт, и ожидание входит
+                // в его задержку: иначе медленные ответы откладывали бы отправку и занижали хвост
+                const auto send_time = start_time + schedule.GetSendTime(index);
+                if (is_open_loop) {
+                    this_thread::sleep_until(send_time);
+                }
+                const auto query_start_time = LatencyStats::Clock::now();
+                try {
+                    ExecuteQuery(search_server, context, records[index % records.size()]);
+                } catch (const exception&) {
+                    ++worker.error_count;
+                }
+                const auto query_end_time = LatencyStats::Clock::now();
+                worker.latencies.Add(query_end_time - (is_open_loop ? send_time : query_start_time));
+                worker.service_times.Add(query_end_time - query_start_time);
+            }
+        });
+    }
+    for (thread& worker : workers) {
+        worker.join();
+    }
+
+    stats.elapsed = LatencyStats::Clock::now() - start_time;
+    stats.query_count = query_count;
+    stats.offered_rate = schedule.GetOfferedRate();
+    for (const ReplayWorkerStats& worker : worker_stats) {
+        stats.latencies.Merge(worker.latencies);
+        stats.service_times.Merge(worker.service_times);
+        stats.error_count += worker.error_count;
+    }
+    return stats;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "search_server.h"
+#include "query_log.h"
+#include "latency_stats.h"
+
+#include <cstddef>
+#include <iostream>
+#include <vector>
+
+enum class QueryReplayMode {
+    // замкнутый цикл: каждый поток отправляет следующий запрос сразу после ответа на предыдущий
+    CLOSED_LOOP,
+    // открытый цикл: запросы отправляются с постоянной частотой rate
+    FIXED_RATE,
+    // открытый цикл: запросы отправляются по отметкам времени журнала, ускоренным в speed раз
+    RECORDED,
+};
+
+struct QueryReplayOptions {
+    std::size_t thread_count = 4;
+    QueryReplayMode mode = QueryReplayMode::CLOSED_LOOP;
+    // запросов в секунду
+    double rate = 1000.0;
+    double speed = 1.0;
+    // сколько раз пройти журнал
+    std::size_t repeat = 1;
+};
+
+struct QueryReplayStats {
+    std::size_t query_count = 0;
+    std::size_t error_count = 0;
+    LatencyStats::Clock::duration elapsed = LatencyStats::Clock::duration::zero();
+    // нагрузка, которую должен был дать открытый цикл; 0 - замкнутый цикл
+    double offered_rate = 0.0;
+    // в открытом цикле - от назначенного времени отправки, то есть вместе с ожиданием свободного потока
+    LatencyStats latencies;
+    // от начала выполнения запроса
+    LatencyStats service_times;
+
+    void Report(std::ostream& out);
+};
+
+// Выполняет запросы журнала на thread_count потоках. Запросы с предикатом выполняются с предикатом,
+// пропускающим все документы: сам предикат в журнал не попадает
+QueryReplayStats ReplayQueries(const SearchServer& search_server, const std::vector<QueryLogRecord>& records,
+                               const QueryReplayOptions& options = {});
@@ -0,0 +1,89 @@
+#include "query_replay.h"
+#include "query_log.h"
+#include "read_input_functions.h"
+#include "search_server.h"
+
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Использование:
+//   query_replay <documents_file> <query_log> [--threads N] [--rate QPS | --speed X] [--repeat N]
+//                [--stop-words "a b c"]
+// Журнал пишет RequestQueue::SetQueryLog. Без --rate и --speed - замкнутый цикл на N потоках (пропускная способность);
+// --rate - открытый цикл с постоянной частотой; --speed - открытый цикл по времени из журнала, ускоренному в X раз.
+// Задержки в открытом цикле считаются от назначенного времени отправки. Статистика пишется в stderr.
+int main(int argc, char* argv[]) {
+    string documents_path;
+    string query_log_path;
+    string stop_words;
+    QueryReplayOptions options;
+    int positional_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--threads"sv && has_value) {
+            options.thread_count = stoul(argv[++i]);
+        } else if (arg == "--rate"sv && has_value) {
+            options.mode = QueryReplayMode::FIXED_RATE;
+            options.rate = stod(argv[++i]);
+        } else if (arg == "--speed"sv && has_value) {
+            options.mode = QueryReplayMode::RECORDED;
+            options.speed = stod(argv[++i]);
+        } else if (arg == "--repeat"sv && has_value) {
+            options.repeat = stoul(argv[++i]);
+        } else if (arg == "--stop-words"sv && has_value) {
+            stop_words = argv[++i];
+        } else if (positional_count == 0) {
+            documents_path = arg;
+            ++positional_count;
+        } else if (positional_count == 1) {
+            query_log_path = arg;
+            ++positional_count;
+        } else {
+            cerr << "Unexpected argument: "s << arg << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (query_log_path.empty()) {
+        cerr << "Usage: "s << argv[0]
+             << " <documents_file> <query_log> [--threads N] [--rate QPS | --speed X] [--repeat N]"s
+             << " [--stop-words \"...\"]"s
+             << endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        SearchServer search_server(stop_words);
+        {
+            ifstream documents(documents_path);
+            if (!documents) {
+                throw runtime_error("Can't open "s + documents_path);
+            }
+            cerr << "Documents loaded: "s << ReadDocuments(documents, search_server) << endl;
+        }
+
+        vector<QueryLogRecord> records;
+        {
+            ifstream query_log(query_log_path, ios::binary);
+            if (!query_log) {
+                throw runtime_error("Can't open "s + query_log_path);
+            }
+            records = ReadQueryLog(query_log);
+            cerr << "Queries loaded: "s << records.size() << endl;
+        }
+
+        ReplayQueries(search_server, records, options).Report(cerr);
+    } catch (const exception& e) {
+        cerr << "Error: "s << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
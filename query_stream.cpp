@@ -0,0 +1,240 @@
+#include "query_stream.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+using namespace std;
+
+//----------------------------------------------------------------------------------------------------------------------
+LineReader::LineReader(istream& input, size_t buffer_size) : input_(input), buffer_(max<size_t>(buffer_size, 1)) {
+}
+
+bool LineReader::FillBuffer() {
+    if (is_eof_) {
+        return false;
+    }
+    input_.read(buffer_.data(), static_cast<streamsize>(buffer_.size()));
+    size_ = static_cast<size_t>(input_.gcount());
+    position_ = 0;
+    if (!input_) {
+        is_eof_ = true;
+    }
+    return size_ > 0;
+}
+
+bool LineReader::ReadLine(string& line) {
+    line.clear();
+    bool has_data = false;
+    while (true) {
+        if (position_ == size_ && !FillBuffer()) {
+            return has_data;
+        }
+        has_data = true;
+        const char* begin = buffer_.data() + position_;
+        const char* end = buffer_.data() + size_;
+        const char* newline = static_cast<const char*>(memchr(begin, '\n', end - begin));
+        if (newline != nullptr) {
+            line.append(begin, newline);
+            position_ += newline - begin + 1;
+            if (!line.empty() && line.back() == '\r') {
+                line.pop_back();
+            }
+            return true;
+        }
+        line.append(begin, end);
+        position_ = size_;
+    }
+}
+//----------------------------------------------------------------------------------------------------------------------
+void QueryStreamStats::Report(ostream& out) {
+    const double seconds = chrono::duration<double>(elapsed).count();
+    out << "Queries: "s << query_count << ", errors: "s << error_count << ", truncated: "s << truncated_count
+        << ", elapsed: "s << chrono::duration_cast<chrono::milliseconds>(elapsed).count() << " ms"s
+        << ", throughput: "s << (seconds > 0 ? static_cast<double>(query_count) / seconds : 0.0) << " qps"s << endl;
+    latencies.Report(out, "Query latency"s);
+}
+//----------------------------------------------------------------------------------------------------------------------
+namespace {
+
+struct QuerySlot {
+    string query;
+    string result;
+    bool is_ready = false;
+    bool is_error = false;
+    bool is_truncated = false;
+};
+
+class QueryPipeline {
+public:
+    QueryPipeline(const SearchServer& search_server, ostream& output, const QueryStreamOptions& options)
+        : search_server_(search_server)
+        , output_(output)
+        , slots_(max<size_t>(options.max_in_flight, 1))
+        , worker_latencies_(max<size_t>(options.thread_count, 1))
+        , query_timeout_(options.query_timeout)
+        , max_postings_(options.max_postings) {
+    }
+
+    void Run(LineReader& reader, QueryStreamStats& stats) {
+        vector<thread> workers;
+        for (size_t i = 0; i < worker_latencies_.size(); ++i) {
+            workers.emplace_back([this, i] { WorkerLoop(worker_latencies_[i]); });
+        }
+        thread writer([this] { WriterLoop(); });
+
+        ReaderLoop(reader);
+
+        for (thread& worker : workers) {
+            worker.join();
+        }
+        writer.join();
+
+        stats.query_count = next_read_;
+        stats.error_count = error_count_;
+        stats.truncated_count = truncated_count_;
+        for (const LatencyStats& latencies : worker_latencies_) {
+            stats.latencies.Merge(latencies);
+        }
+    }
+
+private:
+    const SearchServer& search_server_;
+    ostream& output_;
+    vector<QuerySlot> slots_;
+    vector<LatencyStats> worker_latencies_;
+    const chrono::microseconds query_timeout_;
+    const size_t max_postings_;
+
+    mutex mutex_;
+    condition_variable slot_free_;
+    condition_variable query_ready_;
+    condition_variable result_ready_;
+    size_t next_read_ = 0;
+    size_t next_claim_ = 0;
+    size_t next_write_ = 0;
+    size_t error_count_ = 0;
+    size_t truncated_count_ = 0;
+    bool is_input_done_ = false;
+
+    QuerySlot& GetSlot(size_t index) {
+        return slots_[index % slots_.size()];
+    }
+
+    void ReaderLoop(LineReader& reader) {
+        string line;
+        while (reader.ReadLine(line)) {
+            unique_lock lock(mutex_);
+            slot_free_.wait(lock, [this] { return next_read_ - next_write_ < slots_.size(); });
+            swap(GetSlot(next_read_).query, line);
+            ++next_read_;
+            query_ready_.notify_one();
+        }
+        lock_guard lock(mutex_);
+        is_input_done_ = true;
+        query_ready_.notify_all();
+        result_ready_.notify_all();
+    }
+
+    void WorkerLoop(LatencyStats& latencies) {
+        ostringstream out;
+        SearchServer::QueryContext context;
+        QueryBudget budget;
+        budget.max_postings = max_postings_;
+        while (true) {
+            size_t index;
+            {
+                unique_lock lock(mutex_);
+                query_ready_.wait(lock, [this] { return next_claim_ < next_read_ || is_input_done_; });
+                if (next_claim_ == next_read_) {
+                    return;
+                }
+                index = next_claim_++;
+            }
+
+            QuerySlot& slot = GetSlot(index);
+            out.str(string());
+            slot.is_error = false;
+            slot.is_truncated = false;
+            const auto start_time = LatencyStats::Clock::now();
+            if (query_timeout_ > chrono::microseconds::zero()) {
+                budget.deadline = start_time + query_timeout_;
+            }
+            context.SetBudget(budget);
+            try {
+                bool is_first = true;
+                for (const Document& document : search_server_.FindTopDocuments(context, slot.query)) {
+                    if (!is_first) {
+                        out << ' ';
+                    }
+                    out << document;
+                    is_first = false;
+                }
+                slot.is_truncated = !context.GetStats().is_exact;
+            } catch (const exception& e) {
+                out << "error: "s << e.what();
+                slot.is_error = true;
+            }
+            latencies.Add(LatencyStats::Clock::now() - start_time);
+            out << '\n';
+            slot.result = out.str();
+
+            lock_guard lock(mutex_);
+            slot.is_ready = true;
+            if (index == next_write_) {
+                result_ready_.notify_one();
+            }
+        }
+    }
+
+    void WriterLoop() {
+        while (true) {
+            size_t index;
+            {
+                unique_lock lock(mutex_);
+                result_ready_.wait(lock, [this] {
+                    return (next_write_ < next_read_ && GetSlot(next_write_).is_ready)
+                           || (is_input_done_ && next_write_ == next_read_);
+                });
+                if (next_write_ == next_read_) {
+                    return;
+                }
+                index = next_write_;
+            }
+
+            QuerySlot& slot = GetSlot(index);
+            output_.write(slot.result.data(), static_cast<streamsize>(slot.result.size()));
+
+            lock_guard lock(mutex_);
+            if (slot.is_error) {
+                ++error_count_;
+            }
+            if (slot.is_truncated) {
+                ++truncated_count_;
+            }
+            slot.is_ready = false;
+            ++next_write_;
+            slot_free_.notify_one();
+        }
+    }
+};
+
+} // namespace
+
+QueryStreamStats ProcessQueryStream(const SearchServer& search_server, istream& input, ostream& output,
+                                    const QueryStreamOptions& options) {
+    QueryStreamStats stats;
+    const auto start_time = LatencyStats::Clock::now();
+
+    LineReader reader(input, options.read_buffer_size);
+    QueryPipeline pipeline(search_server, output, options);
+    pipeline.Run(reader, stats);
+    output.flush();
+
+    stats.elapsed = LatencyStats::Clock::now() - start_time;
+    return stats;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "search_server.h"
+#include "latency_stats.h"
+
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Читает строки из потока крупными блоками, без посимвольного getline
+class LineReader {
+public:
+    LineReader(std::istream& input, std::size_t buffer_size);
+
+    bool ReadLine(std::string& line);
+
+private:
+    std::istream& input_;
+    std::vector<char> buffer_;
+    std::size_t position_ = 0;
+    std::size_t size_ = 0;
+    bool is_eof_ = false;
+
+    bool FillBuffer();
+};
+
+struct QueryStreamOptions {
+    std::size_t thread_count = 4;
+    // сколько запросов одновременно прочитано, но ещё не выведено
+    std::size_t max_in_flight = 1024;
+    std::size_t read_buffer_size = 1 << 20;
+    // бюджет каждого запроса (см. QueryBudget): время от начала запроса (0 - без ограничения) и позиции индекса
+    std::chrono::microseconds query_timeout = std::chrono::microseconds::zero();
+    std::size_t max_postings = std::numeric_limits<std::size_t>::max();
+};
+
+struct QueryStreamStats {
+    std::size_t query_count = 0;
+    std::size_t error_count = 0;
+    // запросы, на которые бюджета не хватило
+    std::size_t truncated_count = 0;
+    LatencyStats::Clock::duration elapsed = LatencyStats::Clock::duration::zero();
+    LatencyStats latencies;
+
+    void Report(std::ostream& out);
+};
+
+// Выполняет FindTopDocuments для каждой строки input на пуле потоков,
+// результаты пишутся в output в порядке следования запросов
+QueryStreamStats ProcessQueryStream(const SearchServer& search_server, std::istream& input, std::ostream& output,
+                                    const QueryStreamOptions& options = {});
@@ -0,0 +1,93 @@
+#include "query_stream.h"
+#include "read_input_functions.h"
+#include "search_server.h"
+#include "perf_counters.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Использование:
+//   query_stream <documents_file> [queries_file|-] [--threads N] [--in-flight N] [--buffer BYTES] [--stop-words "a b c"]
+//                [--timeout-us N] [--max-postings N]
+// Результаты пишутся в stdout (одна строка на запрос, в порядке входа), статистика - в stderr.
+// --timeout-us, --max-postings - бюджет каждого запроса (QueryBudget); сколько запросов его исчерпали - в статистике.
+// При сборке с SEARCH_SERVER_PERF_COUNTERS в конце выводятся средние аппаратные счётчики по участкам (perf_counters.h).
+int main(int argc, char* argv[]) {
+    ios::sync_with_stdio(false);
+
+    string documents_path;
+    string queries_path = "-"s;
+    string stop_words;
+    QueryStreamOptions options;
+    int positional_count = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        const bool has_value = i + 1 < argc;
+        if (arg == "--threads"sv && has_value) {
+            options.thread_count = stoul(argv[++i]);
+        } else if (arg == "--in-flight"sv && has_value) {
+            options.max_in_flight = stoul(argv[++i]);
+        } else if (arg == "--buffer"sv && has_value) {
+            options.read_buffer_size = stoul(argv[++i]);
+        } else if (arg == "--stop-words"sv && has_value) {
+            stop_words = argv[++i];
+        } else if (arg == "--timeout-us"sv && has_value) {
+            options.query_timeout = chrono::microseconds(stoll(argv[++i]));
+        } else if (arg == "--max-postings"sv && has_value) {
+            options.max_postings = stoull(argv[++i]);
+        } else if (positional_count == 0) {
+            documents_path = arg;
+            ++positional_count;
+        } else if (positional_count == 1) {
+            queries_path = arg;
+            ++positional_count;
+        } else {
+            cerr << "Unexpected argument: "s << arg << endl;
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (documents_path.empty()) {
+        cerr << "Usage: "s << argv[0]
+             << " <documents_file> [queries_file|-] [--threads N] [--in-flight N] [--buffer BYTES] [--stop-words \"...\"]"s
+             << " [--timeout-us N] [--max-postings N]"s
+             << endl;
+        return EXIT_FAILURE;
+    }
+
+    try {
+        SearchServer search_server(stop_words);
+        {
+            ifstream documents(documents_path);
+            if (!documents) {
+                throw runtime_error("Can't open "s + documents_path);
+            }
+            cerr << "Documents loaded: "s << ReadDocuments(documents, search_server) << endl;
+        }
+
+        QueryStreamStats stats;
+        if (queries_path == "-"sv) {
+            stats = ProcessQueryStream(search_server, cin, cout, options);
+        } else {
+            ifstream queries(queries_path, ios::binary);
+            if (!queries) {
+                throw runtime_error("Can't open "s + queries_path);
+            }
+            stats = ProcessQueryStream(search_server, queries, cout, options);
+        }
+        stats.Report(cerr);
+        ReportPerfScopes(cerr);
+    } catch (const exception& e) {
+        cerr << "Error: "s << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
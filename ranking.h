@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Модели ранжирования передаются в FindTopDocuments параметром шаблона, поэтому оценка
+// встраивается в цикл по индексу без виртуальных вызовов. Модель - тип со статическими функциями:
+//   ComputeTermWeight(document_count, document_freq) - вес слова запроса (считается раз на запрос)
+//   ComputeScore(term_freq, term_weight, document_length, average_document_length) - вклад слова в документ,
+//   где term_freq - доля слова среди слов документа, document_length - число слов документа без стоп-слов
+
+struct TfIdfRanking {
+    static double ComputeTermWeight(int document_count, std::size_t document_freq) {
+        return std::log(document_count * 1.0 / static_cast<double>(document_freq));
+    }
+
+    static double ComputeScore(double term_freq, double term_weight, uint32_t /*document_length*/,
+                               double /*average_document_length*/) {
+        return term_freq * term_weight;
+    }
+};
+
+struct Bm25Ranking {
+    static constexpr double K1 = 1.2;
+    static constexpr double B = 0.75;
+
+    static double ComputeTermWeight(int document_count, std::size_t document_freq) {
+        const double freq = static_cast<double>(document_freq);
+        return std::log((document_count - freq + 0.5) / (freq + 0.5) + 1.0);
+    }
+
+    // term_freq в индексе - сумма 1/document_length по вхождениям слова; её ошибка округления много меньше
+    // 1/(2*document_length), поэтому round восстанавливает число вхождений точно
+    static double ComputeScore(double term_freq, double term_weight, uint32_t document_length,
+                               double average_document_length) {
+        const double count = std::round(term_freq * document_length);
+        const double length_norm = K1 * (1.0 - B + B * document_length / average_document_length);
+        return term_weight * count * (K1 + 1.0) / (count + length_norm);
+    }
+};
+
+// Статистика коллекции для весов слов. По умолчанию сервер берёт её из своего индекса;
+// шардированный сервер передаёт общую статистику, чтобы релевантность совпадала с нешардированной.
+struct CollectionStatistics {
+    int document_count = 0;
+    double average_document_length = 0.0;
+    // число документов со словом, по возрастанию слова
+    std::vector<std::pair<std::string_view, std::size_t>> document_freqs;
+
+    std::size_t GetDocumentFreq(std::string_view word) const {
+        const auto it = std::lower_bound(document_freqs.begin(), document_freqs.end(), word,
+                                         [](const auto &item, std::string_view value) {
+                                             return item.first < value;
+                                         });
+        return it != document_freqs.end() && it->first == word ? it->second : 0;
+    }
+};
@@ -16,3 +16,17 @@ int ReadLineWithNumber() {
     ReadLine();
     return result;
 }
+
+int ReadDocuments(istream& input, SearchServer& search_server) {
+    int document_id = 0;
+    string line;
+    while (getline(input, line)) {
+        // файлы с переводами строк Windows, как и в LineReader
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        search_server.AddDocument(document_id, line, DocumentStatus::ACTUAL, {});
+        ++document_id;
+    }
+    return document_id;
+}
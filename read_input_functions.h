@@ -1,7 +1,13 @@
 #pragma once
 
+#include "search_server.h"
+
+#include <iostream>
 #include <string>
 
 std::string ReadLine();
 
 int ReadLineWithNumber();
+
+// Каждая строка потока - отдельный документ, id документа - номер строки (с нуля)
+int ReadDocuments(std::istream& input, SearchServer& search_server);
@@ -1,27 +1,27 @@
 #include "remove_duplicates.h"
 
 #include <string>
-#include <map>
+#include <string_view>
 #include <set>
+#include <vector>
 
 using namespace std;
 
 void RemoveDuplicates(SearchServer& search_server) {
     set<int> ids_to_remove;
-    set<set<string>> words_sets;
+    // слова документа идут в порядке term_id, поэтому одинаковые наборы слов дают одинаковые векторы
+    set<vector<string_view>> words_sets;
 
     for (auto document_id_ : search_server) {
-        map<string, double> word_frequency = search_server.GetWordFrequencies(document_id_);
-
-        set<string> words_set;
-        for (auto [word, frequency] : word_frequency) {
-            words_set.insert(word);
+        vector<string_view> words_set;
+        for (auto [word, frequency] : search_server.GetWordFrequencies(document_id_)) {
+            words_set.push_back(word);
         }
         if (words_sets.count(words_set)) {
             ids_to_remove.insert(document_id_);
             continue;
         }
-        words_sets.insert(words_set);
+        words_sets.insert(move(words_set));
     }
 
     for(int id : ids_to_remove) {
@@ -5,10 +5,12 @@
 using namespace std;
 
 vector<Document> RequestQueue::AddFindRequest(string_view raw_query, DocumentStatus status) {
+    LogRequest(raw_query, QueryFilterKind::STATUS, status);
     return RequestProcessing(search_server_.FindTopDocuments(raw_query, status));
 }
 
 vector<Document> RequestQueue::AddFindRequest(string_view raw_query) {
+    LogRequest(raw_query, QueryFilterKind::DEFAULT, DocumentStatus::ACTUAL);
     return RequestProcessing(search_server_.FindTopDocuments(raw_query));
 }
 
@@ -16,6 +18,16 @@ int RequestQueue::GetNoResultRequests() const {
     return NoResultRequests;
 }
 
+void RequestQueue::SetQueryLog(QueryLogWriter *query_log) {
+    query_log_ = query_log;
+}
+
+void RequestQueue::LogRequest(string_view raw_query, QueryFilterKind filter_kind, DocumentStatus status) {
+    if (query_log_ != nullptr) {
+        query_log_->Write(raw_query, filter_kind, status);
+    }
+}
+
 vector<Document> RequestQueue::RequestProcessing(vector<Document> result) {
     if (requests_.size() >= min_in_day_) {
         if (requests_.front().is_empty == 1)
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "search_server.h"
+#include "query_log.h"
 
 #include <string>
 #include <deque>
@@ -13,6 +14,7 @@ public:
     // сделаем "обёртки" для всех методов поиска, чтобы сохранять результаты для нашей статистики
     template<typename DocumentPredicate>
     std::vector<Document> AddFindRequest(std::string_view raw_query, DocumentPredicate document_predicate) {
+        LogRequest(raw_query, QueryFilterKind::PREDICATE, DocumentStatus::ACTUAL);
         return RequestProcessing(search_server_.FindTopDocuments(raw_query, document_predicate));
     }
 
@@ -22,6 +24,10 @@ public:
 
     int GetNoResultRequests() const;
 
+    // Журнал, в который пишется каждый запрос до его выполнения; nullptr - не писать.
+    // Журнал должен жить дольше очереди
+    void SetQueryLog(QueryLogWriter *query_log);
+
 private:
     struct QueryResult {
         QueryResult() {
@@ -32,9 +38,12 @@ private:
     };
 
     const SearchServer &search_server_;
+    QueryLogWriter *query_log_ = nullptr;
     std::deque<QueryResult> requests_;
     const static int min_in_day_ = 1440;
     int NoResultRequests = 0;
 
+    void LogRequest(std::string_view raw_query, QueryFilterKind filter_kind, DocumentStatus status);
+
     std::vector<Document> RequestProcessing(std::vector<Document> result);
 };
@@ -17,24 +17,70 @@
 
 using namespace std;
 
+bool IsMoreRelevant(const Document &lhs, const Document &rhs) {
+    if (abs(lhs.relevance - rhs.relevance) < NUMBERS_EQUAL_CHECK) {
+        // при полном совпадении - меньший id, чтобы выдача не зависела от порядка сортировки и разбиения на шарды
+        return lhs.rating != rhs.rating ? lhs.rating > rhs.rating : lhs.id < rhs.id;
+    } else {
+        return lhs.relevance > rhs.relevance;
+    }
+}
+
 //----------------------------------------------------------------------------------------------------------------------
 SearchServer::SearchServer(const string& stop_words_text): SearchServer(SplitIntoWords(stop_words_text)) {}
 
 SearchServer::SearchServer(string_view stop_words_view): SearchServer(SplitIntoWords(stop_words_view)) {}
 //----------------------------------------------------------------------------------------------------------------------
 void SearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,const vector<int> &ratings) {
+    PERF_SCOPE("SearchServer::AddDocument");
     if ((document_id < 0) || (documents_.count(document_id) > 0)) {
         throw invalid_argument("Invalid document_id"s);
     }
     const vector<string_view> words = SplitIntoWordsNoStop(document);
 
     const double inv_word_count = 1.0 / static_cast<double>(words.size());
+    vector<uint32_t> term_ids;
+    term_ids.reserve(words.size());
+    // слова, у которых может быть список чемпионов; доля слова известна только после всего документа
+    vector<pair<string_view, const PostingList *>> champion_words;
     for (string_view word: words) {
-        auto insert_word = all_words_.insert(string(word)); // ссылка на копию переданных в метод данных
-        word_to_document_freqs_[*insert_word.first][document_id] += inv_word_count;
-        document_to_word_freqs_[document_id][word] += inv_word_count;
+        // известное слово - без построения WordString; слово, которого нет в фильтре, точно новое
+        auto word_iter = vocabulary_filter_.MayContain(word) ? all_words_.find(word) : all_words_.end();
+        if (word_iter == all_words_.end()) {
+            word_iter = all_words_.emplace(WordString(word), static_cast<uint32_t>(term_words_.size())).first;
+            all_words_heap_size_ += EstimateStringHeapSize(word_iter->first);
+            term_words_.push_back(word_iter->first); // ссылка на копию переданных в метод данных
+            vocabulary_filter_.Add(term_words_.back(), term_words_);
+        }
+        const uint32_t term_id = word_iter->second;
+        PostingList &postings = word_to_document_freqs_[term_words_[term_id]];
+        postings[document_id] += inv_word_count;
+        if (postings.size() >= CHAMPION_MIN_DOCUMENT_FREQ / 2) {
+            champion_words.emplace_back(term_words_[term_id], &postings);
+        }
+        term_ids.push_back(term_id);
     }
-    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status});
+    sort(champion_words.begin(), champion_words.end());
+    champion_words.erase(unique(champion_words.begin(), champion_words.end()), champion_words.end());
+    for (const auto &[word, postings] : champion_words) {
+        AddChampionPosting(word, *postings, document_id);
+    }
+
+    sort(term_ids.begin(), term_ids.end());
+    const size_t forward_offset = forward_index_.size();
+    for (auto it = term_ids.begin(); it != term_ids.end();) {
+        const auto run_end = upper_bound(it, term_ids.end(), *it);
+        forward_index_.push_back({*it, static_cast<uint32_t>(run_end - it)});
+        it = run_end;
+    }
+    const size_t forward_size = forward_index_.size() - forward_offset;
+
+    posting_count_ += forward_size;
+    total_word_count_ += words.size();
+    ResetImpacts();
+    documents_.emplace(document_id, DocumentData{ComputeAverageRating(ratings), status, AcquireOrdinal(),
+                                                 static_cast<uint32_t>(words.size()),
+                                                 static_cast<uint32_t>(forward_size), forward_offset});
     document_ids_.insert(document_id);
 }
 //------------------------------------------------------------------------------------------------------------------
@@ -48,11 +94,24 @@ vector<Document> SearchServer::FindTopDocuments(string_view raw_query) const {
     return FindTopDocuments(raw_query, DocumentStatus::ACTUAL);
 }
 
+SearchServer::QueryContext &SearchServer::GetThreadQueryContext() {
+    thread_local QueryContext context;
+    return context;
+}
+
+void SearchServer::KeepTopDocuments(vector<Document> &matched_documents) {
+    sort(matched_documents.begin(), matched_documents.end(), IsMoreRelevant);
+
+    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
+        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+    }
+}
+
 //----------------------------------------------------------------------------------------------------------------------
-set<int>::const_iterator SearchServer::begin() const {
+SearchServer::DocumentIds::const_iterator SearchServer::begin() const {
     return document_ids_.begin();
 }
-set<int>::const_iterator SearchServer::end() const {
+SearchServer::DocumentIds::const_iterator SearchServer::end() const {
     return document_ids_.end();
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -60,14 +119,77 @@ int SearchServer::GetDocumentCount() const {
     return static_cast<int>(documents_.size());
 }
 
-const map<string_view, double> &SearchServer::GetWordFrequencies(int document_id) const {
-    auto iter = document_to_word_freqs_.find(document_id);
-    if (iter != document_to_word_freqs_.end()) {
-        return iter->second;
+uint32_t SearchServer::GetDocumentLength(int document_id) const {
+    const auto iter = documents_.find(document_id);
+    return iter == documents_.end() ? 0 : iter->second.word_count;
+}
+
+double SearchServer::GetAverageDocumentLength() const {
+    return documents_.empty() ? 0.0 : static_cast<double>(total_word_count_) / static_cast<double>(documents_.size());
+}
+
+WordFrequenciesView SearchServer::GetWordFrequencies(int document_id) const {
+    auto iter = documents_.find(document_id);
+    if (iter == documents_.end()) {
+        return {};
     }
 
-    static const map<string_view, double> empty_map{};
-    return empty_map;
+    const DocumentData &document_data = iter->second;
+    const ForwardIndexEntry *entries = forward_index_.data() + document_data.forward_offset;
+    return {entries, entries + document_data.forward_size, term_words_.data(), document_data.word_count};
+}
+
+MemoryUsage SearchServer::GetMemoryUsage() const {
+    MemoryUsage usage;
+    usage.term_count = word_to_document_freqs_.size();
+    usage.posting_count = posting_count_;
+    usage.document_count = documents_.size();
+
+#ifdef SEARCH_SERVER_COUNT_ALLOCATIONS
+    usage.all_words = GetAllocatedIndexBytes(IndexStructure::ALL_WORDS);
+    usage.word_to_document_freqs = GetAllocatedIndexBytes(IndexStructure::WORD_TO_DOCUMENT_FREQS);
+    usage.document_to_word_freqs = GetAllocatedIndexBytes(IndexStructure::DOCUMENT_TO_WORD_FREQS);
+    usage.documents = GetAllocatedIndexBytes(IndexStructure::DOCUMENTS);
+    usage.document_ids = GetAllocatedIndexBytes(IndexStructure::DOCUMENT_IDS);
+    usage.impacts = GetAllocatedIndexBytes(IndexStructure::IMPACTS);
+    usage.champion_lists = GetAllocatedIndexBytes(IndexStructure::CHAMPIONS);
+    usage.is_exact = true;
+#else
+    usage.all_words = all_words_.size() * EstimateTreeNodeSize<decltype(all_words_)::value_type>() + all_words_heap_size_
+                      + EstimateAllocationSize(term_words_.capacity() * sizeof(string_view));
+    usage.word_to_document_freqs =
+            word_to_document_freqs_.size() * EstimateTreeNodeSize<decltype(word_to_document_freqs_)::value_type>()
+            + posting_count_ * EstimateTreeNodeSize<PostingList::value_type>();
+    usage.document_to_word_freqs = EstimateAllocationSize(forward_index_.capacity() * sizeof(ForwardIndexEntry));
+    usage.documents = documents_.size() * EstimateTreeNodeSize<decltype(documents_)::value_type>();
+    usage.document_ids = document_ids_.size() * EstimateTreeNodeSize<DocumentIds::value_type>();
+    usage.impacts = impacts_.size() * EstimateTreeNodeSize<decltype(impacts_)::value_type>() + impacts_size_;
+    usage.champion_lists = champion_lists_.size() * EstimateTreeNodeSize<decltype(champion_lists_)::value_type>()
+                           + champion_lists_size_;
+#endif
+
+    // стоп-слова и фильтры не входят в CountingAllocator и всегда оцениваются
+    for (const string &word : stop_words_) {
+        usage.stop_words += EstimateTreeNodeSize<string>() + EstimateStringHeapSize(word);
+    }
+    usage.stop_words += stop_word_table_.GetHeapSize();
+    usage.all_words += vocabulary_filter_.GetHeapSize();
+    return usage;
+}
+//----------------------------------------------------------------------------------------------------------------------
+void SearchServer::SetThreadPool(shared_ptr<ThreadPool> thread_pool) {
+    thread_pool_ = move(thread_pool);
+}
+
+ThreadPool &SearchServer::GetThreadPool() const {
+    return thread_pool_ ? *thread_pool_ : ThreadPool::GetDefault();
+}
+
+void SearchServer::SetParallelGrainSize(size_t grain_size) {
+    if (grain_size == 0) {
+        throw invalid_argument("Grain size must be positive"s);
+    }
+    parallel_grain_size_ = grain_size;
 }
 //----------------------------------------------------------------------------------------------------------------------
 void SearchServer::RemoveDocument(int document_id) {
@@ -75,13 +197,26 @@ void SearchServer::RemoveDocument(int document_id) {
         throw invalid_argument("There is no document with this id.");
     }
 
-    for (auto [word, frequency]: GetWordFrequencies(document_id)) {
-        word_to_document_freqs_.erase(word_to_document_freqs_.find(word));
+    const WordFrequenciesView word_frequencies = GetWordFrequencies(document_id);
+    for (const auto [word, frequency]: word_frequencies) {
+        auto word_iter = word_to_document_freqs_.find(word);
+        word_iter->second.erase(document_id);
+        RemoveChampionPosting(word_iter->first, word_iter->second, document_id);
+        if (word_iter->second.empty()) {
+            word_to_document_freqs_.erase(word_iter);
+        }
     }
+    posting_count_ -= word_frequencies.size();
+    forward_index_garbage_ += word_frequencies.size();
+    total_word_count_ -= documents_.at(document_id).word_count;
+    free_ordinals_.push_back(documents_.at(document_id).ordinal);
+    ResetImpacts();
 
     documents_.erase(document_id);
     document_ids_.erase(document_id);
-    document_to_word_freqs_.erase(document_id);
+    if (forward_index_garbage_ * 2 > forward_index_.size()) {
+        CompactForwardIndex();
+    }
 }
 
 //----------------------------------------------------------------------------------------------------------------------
@@ -96,20 +231,20 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_vi
 
     const Query query = ParseQuery(raw_query, false);
 
-    if (any_of(query.minus_words.begin(), query.minus_words.end(),
-               [this, document_id](string_view word) {
-                   return word_to_document_freqs_.count(word) && word_to_document_freqs_.find(word)->second.count(document_id);
-               })) {
+    auto word_in_document = [this, document_id](string_view word) {
+        const PostingList *postings = FindPostingList(word);
+        return postings != nullptr && postings->count(document_id) > 0;
+    };
+
+    if (any_of(query.minus_words.begin(), query.minus_words.end(), word_in_document)
+        || !all_of(query.required_words.begin(), query.required_words.end(), word_in_document)) {
         return {vector<string_view>(), documents_.at(document_id).status};
     }
 
     vector<string_view> matched_words;
 
     for (string_view word: query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        if (word_to_document_freqs_.find(word)->second.count(document_id)) {
+        if (word_in_document(word)) {
             matched_words.push_back(word);
         }
     }
@@ -120,7 +255,7 @@ tuple<vector<string_view>, DocumentStatus> SearchServer::MatchDocument(string_vi
 
 //----------------------------------------------------------------------------------------------------------------------
 bool SearchServer::IsStopWord(string_view word) const {
-    return stop_words_.count(word) > 0;
+    return stop_word_table_.Contains(word);
 }
 
 bool SearchServer::IsValidWord(string_view word) {
@@ -148,27 +283,45 @@ SearchServer::QueryWord SearchServer::ParseQueryWord(string_view text) const {
     }
 
     bool is_minus = false;
+    bool is_required = false;
 
     if (text[0] == '-') {
         is_minus = true;
         text = text.substr(1);
+    } else if (text[0] == '+') {
+        is_required = true;
+        text = text.substr(1);
     }
 
-    if (text.empty() || text[0] == '-' || !IsValidWord(text)) {
+    if (text.empty() || text[0] == '-' || text[0] == '+' || !IsValidWord(text)) {
         throw invalid_argument("Query word is invalid");
     }
-    return {text, is_minus, IsStopWord(text)};
+    return {text, is_minus, is_required, IsStopWord(text)};
 }
 //----------------------------------------------------------------------------------------------------------------------
 SearchServer::Query SearchServer::ParseQuery(string_view text, bool is_parallel) const {
     Query result;
-    for (string_view word: SplitIntoWords(text)) {
+    vector<string_view> words;
+    ParseQuery(text, is_parallel, words, result);
+    return result;
+}
+
+void SearchServer::ParseQuery(string_view text, bool is_parallel, vector<string_view> &words, Query &result) const {
+    PERF_SCOPE("SearchServer::ParseQuery");
+    result.plus_words.clear();
+    result.required_words.clear();
+    result.minus_words.clear();
+    SplitIntoWords(text, words);
+    for (string_view word: words) {
         const QueryWord query_word = ParseQueryWord(word);
         if (!query_word.is_stop) {
             if (query_word.is_minus) {
                 result.minus_words.push_back(query_word.data);
             } else {
                 result.plus_words.push_back(query_word.data);
+                if (query_word.is_required) {
+                    result.required_words.push_back(query_word.data);
+                }
             }
         }
     }
@@ -178,9 +331,9 @@ SearchServer::Query SearchServer::ParseQuery(string_view text, bool is_parallel)
         result.minus_words.erase(unique(result.minus_words.begin(), result.minus_words.end()),result.minus_words.end());
         sort(result.plus_words.begin(), result.plus_words.end());
         result.plus_words.erase(unique(result.plus_words.begin(), result.plus_words.end()), result.plus_words.end());
+        sort(result.required_words.begin(), result.required_words.end());
+        result.required_words.erase(unique(result.required_words.begin(), result.required_words.end()), result.required_words.end());
     }
-
-    return result;
 }
 //----------------------------------------------------------------------------------------------------------------------
 int SearchServer::ComputeAverageRating(const vector<int> &ratings) {
@@ -191,7 +344,327 @@ int SearchServer::ComputeAverageRating(const vector<int> &ratings) {
     return rating_sum / static_cast<int>(ratings.size());
 }
 
-double SearchServer::ComputeWordInverseDocumentFreq(string_view word) const {
-    return log(GetDocumentCount() * 1.0 / static_cast<double>(word_to_document_freqs_.find(word)->second.size()));
+void SearchServer::CompactForwardIndex() {
+    decltype(forward_index_) compacted;
+    compacted.reserve(forward_index_.size() - forward_index_garbage_);
+    for (auto &[document_id, document_data] : documents_) {
+        const auto entries_begin = forward_index_.begin() + static_cast<ptrdiff_t>(document_data.forward_offset);
+        document_data.forward_offset = compacted.size();
+        compacted.insert(compacted.end(), entries_begin, entries_begin + document_data.forward_size);
+    }
+    forward_index_.swap(compacted);
+    forward_index_garbage_ = 0;
+}
+
+uint32_t SearchServer::AcquireOrdinal() {
+    if (free_ordinals_.empty()) {
+        return ordinal_count_++;
+    }
+    const uint32_t ordinal = free_ordinals_.back();
+    free_ordinals_.pop_back();
+    return ordinal;
+}
+
+void SearchServer::ResetImpacts() {
+    if (impacts_model_ != nullptr) {
+        impacts_.clear();
+        impacts_model_ = nullptr;
+        impacts_size_ = 0;
+    }
+}
+
+void SearchServer::AddChampionPosting(string_view word, const PostingList &postings, int document_id) {
+    const auto champions_iter = champion_lists_.find(word);
+    if (champions_iter == champion_lists_.end()) {
+        if (postings.size() >= CHAMPION_MIN_DOCUMENT_FREQ) {
+            BuildChampionList(postings, champion_lists_[word]);
+        }
+        return;
+    }
+
+    ChampionList &champions = champions_iter->second;
+    const double term_freq = postings.at(document_id);
+    if (term_freq <= champions.max_other_term_freq) {
+        return;
+    }
+    if (champions.postings.size() >= 2 * CHAMPION_LIST_SIZE) {
+        BuildChampionList(postings, champions);
+        return;
+    }
+    champion_lists_size_ -= EstimateAllocationSize(champions.postings.capacity() * sizeof(ChampionPosting));
+    champions.postings.insert(FindFirstPosting(champions.postings, document_id), {document_id, term_freq});
+    champion_lists_size_ += EstimateAllocationSize(champions.postings.capacity() * sizeof(ChampionPosting));
+}
+
+void SearchServer::RemoveChampionPosting(string_view word, const PostingList &postings, int document_id) {
+    // список удаляется, как только слово станет реже CHAMPION_MIN_DOCUMENT_FREQ / 2
+    if (postings.size() + 1 < CHAMPION_MIN_DOCUMENT_FREQ / 2) {
+        return;
+    }
+    const auto champions_iter = champion_lists_.find(word);
+    if (champions_iter == champion_lists_.end()) {
+        return;
+    }
+
+    ChampionList &champions = champions_iter->second;
+    if (postings.size() < CHAMPION_MIN_DOCUMENT_FREQ / 2) {
+        champion_lists_size_ -= EstimateAllocationSize(champions.postings.capacity() * sizeof(ChampionPosting));
+        champion_lists_.erase(champions_iter);
+        return;
+    }
+    const auto posting = FindFirstPosting(champions.postings, document_id);
+    if (posting == champions.postings.end() || posting->document_id != document_id) {
+        return;
+    }
+    champions.postings.erase(posting);
+    if (champions.postings.size() < CHAMPION_LIST_SIZE / 2) {
+        BuildChampionList(postings, champions);
+    }
+}
+
+void SearchServer::BuildChampionList(const PostingList &postings, ChampionList &champions) {
+    vector<ChampionPosting> candidates;
+    candidates.reserve(postings.size());
+    for (const auto [document_id, term_freq] : postings) {
+        candidates.push_back({document_id, term_freq});
+    }
+    champions.max_other_term_freq = 0.0;
+    if (candidates.size() > CHAMPION_LIST_SIZE) {
+        const auto champions_end = candidates.begin() + static_cast<ptrdiff_t>(CHAMPION_LIST_SIZE);
+        nth_element(candidates.begin(), champions_end, candidates.end(), [](const ChampionPosting &lhs, const ChampionPosting &rhs) {
+            return lhs.term_freq > rhs.term_freq;
+        });
+        champions.max_other_term_freq = champions_end->term_freq;
+        candidates.erase(champions_end, candidates.end());
+    }
+    sort(candidates.begin(), candidates.end(), [](const ChampionPosting &lhs, const ChampionPosting &rhs) {
+        return lhs.document_id < rhs.document_id;
+    });
+
+    champion_lists_size_ -= EstimateAllocationSize(champions.postings.capacity() * sizeof(ChampionPosting));
+    champions.postings.assign(candidates.begin(), candidates.end());
+    champions.postings.shrink_to_fit();
+    champion_lists_size_ += EstimateAllocationSize(champions.postings.capacity() * sizeof(ChampionPosting));
+}
+//----------------------------------------------------------------------------------------------------------------------
+const SearchServer::PostingList *SearchServer::FindPostingList(string_view word) const {
+    if (!vocabulary_filter_.MayContain(word)) {
+        return nullptr;
+    }
+    const auto word_iter = word_to_document_freqs_.find(word);
+    return word_iter == word_to_document_freqs_.end() ? nullptr : &word_iter->second;
+}
+
+const SearchServer::PostingList *SearchServer::FindPostingList(const QueryContext &context, string_view word) const {
+    const CollectionStatistics *statistics = context.collection_statistics_;
+    if (statistics != nullptr && statistics->GetDocumentFreq(word) == 0) {
+        return nullptr;
+    }
+    return FindPostingList(word);
+}
+
+const SearchServer::ChampionList *SearchServer::FindChampionList(string_view word) const {
+    const auto champions_iter = champion_lists_.find(word);
+    return champions_iter == champion_lists_.end() ? nullptr : &champions_iter->second;
+}
+
+void SearchServer::GetMinusTerms(const Query &query, vector<const PostingList *> &minus_terms) const {
+    minus_terms.clear();
+    for (string_view word : query.minus_words) {
+        if (const PostingList *postings = FindPostingList(word)) {
+            minus_terms.push_back(postings);
+        }
+    }
+}
+
+bool SearchServer::GetRequiredTerms(QueryContext &context) const {
+    vector<const PostingList *> &required_terms = context.required_terms_;
+    required_terms.clear();
+    for (string_view word : context.query_.required_words) {
+        const PostingList *postings = FindPostingList(context, word);
+        if (postings == nullptr) {
+            return false;
+        }
+        required_terms.push_back(postings);
+    }
+    sort(required_terms.begin(), required_terms.end(), [](const PostingList *lhs, const PostingList *rhs) {
+        return lhs->size() < rhs->size();
+    });
+    return true;
+}
+
+void SearchServer::SelectChampionLists(QueryContext &context) {
+    context.use_champions_ = false;
+    context.champion_bound_ = 0.0;
+    // запрос с "+" и так обходит только пересечение; вес меньше нуля делает границу вклада неверной
+    const bool can_use_champions = context.required_terms_.empty()
+            && none_of(context.plus_terms_.begin(), context.plus_terms_.end(), [](const TermPostings &term) {
+                   return term.weight < 0.0;
+               });
+    for (TermPostings &term : context.plus_terms_) {
+        if (!can_use_champions) {
+            term.champions = nullptr;
+        } else if (term.champions != nullptr) {
+            context.use_champions_ = true;
+            context.champion_bound_ += term.champions->max_other_term_freq * term.weight;
+        }
+    }
+}
+
+bool SearchServer::KeepChampionResult(QueryContext &context) {
+    // документы вне обойдённых списков набирают не больше champion_bound_: если K-й найденный документ
+    // релевантнее, топ тот же, что по полным спискам (запас - как в ScoreDocumentRange)
+    TopRelevances top_relevances;
+    for (const Document &document : context.matched_documents_) {
+        top_relevances.Add(document.relevance);
+    }
+    if (top_relevances.GetLowest() - context.champion_bound_ >= 2 * NUMBERS_EQUAL_CHECK) {
+        return true;
+    }
+    // с бюджетом пересчёт по полным спискам - только если срок не наступил, все слова обработаны
+    // и полные списки помещаются в остаток max_postings; иначе бюджет исчерпан и результат неточный
+    const QueryBudget &budget = context.budget_;
+    if (budget.IsLimited()) {
+        size_t full_posting_count = 0;
+        for (const TermPostings &term : context.plus_terms_) {
+            full_posting_count += term.postings->size();
+        }
+        const QueryStats &stats = context.stats_;
+        const bool can_rescore = stats.processed_term_count == stats.term_count
+                && (!budget.HasDeadline() || QueryBudget::Clock::now() < budget.deadline)
+                && stats.posting_count <= budget.max_postings
+                && full_posting_count <= budget.max_postings - stats.posting_count;
+        if (!can_rescore) {
+            context.stats_.is_exact = false;
+            return true;
+        }
+    }
+    for (TermPostings &term : context.plus_terms_) {
+        term.champions = nullptr;
+    }
+    context.use_champions_ = false;
+    // срок для каждого слова проверяется заново
+    context.deadline_decision_.store(0, memory_order_relaxed);
+    return false;
+}
+
+size_t SearchServer::GetScannedPostingCount(const TermPostings &term) {
+    return term.champions != nullptr ? term.champions->postings.size() : term.postings->size();
+}
+
+void SearchServer::ApplyBudget(QueryContext &context) const {
+    context.stats_ = QueryStats{};
+    context.stats_.term_count = context.plus_terms_.size();
+    context.term_limit_ = context.plus_terms_.size();
+    context.intersection_upper_id_ = MAX_DOCUMENT_ID_BOUND;
+    context.deadline_decision_.store(0, memory_order_relaxed);
+    const QueryBudget &budget = context.budget_;
+    if (!budget.IsLimited()) {
+        return;
+    }
+
+    if (!context.required_terms_.empty()) {
+        // пересечение обходит самый короткий список по возрастанию id: max_postings задаёт границу id,
+        // одинаковую для последовательной и параллельной версий. Как и самое редкое слово без "+",
+        // первая позиция обходится всегда
+        const PostingList &rarest = *context.required_terms_.front();
+        const size_t max_postings = max<size_t>(budget.max_postings, 1);
+        if (rarest.size() > max_postings) {
+            context.intersection_upper_id_ = next(rarest.begin(), static_cast<ptrdiff_t>(max_postings))->first;
+            context.stats_.is_exact = false;
+        }
+        return;
+    }
+
+    // сначала слова с наибольшим весом: при нехватке бюджета отбрасываются самые частые
+    stable_sort(context.plus_terms_.begin(), context.plus_terms_.end(), [](const TermPostings &lhs, const TermPostings &rhs) {
+        return lhs.weight > rhs.weight;
+    });
+    // самое редкое слово берётся всегда: иначе бюджет меньше самого короткого списка давал бы пустой результат
+    size_t posting_count = 0;
+    size_t term_limit = 0;
+    for (; term_limit < context.plus_terms_.size(); ++term_limit) {
+        const size_t term_posting_count = GetScannedPostingCount(context.plus_terms_[term_limit]);
+        if (term_limit > 0 && term_posting_count > budget.max_postings - min(posting_count, budget.max_postings)) {
+            break;
+        }
+        posting_count += term_posting_count;
+    }
+    context.term_limit_ = term_limit;
+}
+
+bool SearchServer::IsTermWithinDeadline(QueryContext &context, size_t term_index) {
+    size_t decision = context.deadline_decision_.load(memory_order_acquire);
+    while (true) {
+        const size_t allowed_term_count = decision >> 1;
+        if (term_index < allowed_term_count) {
+            return true;
+        }
+        if ((decision & 1) != 0) {
+            return false;
+        }
+        // до слова доходят только после разрешения предыдущего, поэтому здесь term_index == allowed_term_count
+        const size_t next_decision = QueryBudget::Clock::now() < context.budget_.deadline
+                                     ? (term_index + 1) << 1
+                                     : term_index << 1 | 1;
+        if (context.deadline_decision_.compare_exchange_weak(decision, next_decision, memory_order_acq_rel,
+                                                             memory_order_acquire)) {
+            return (next_decision & 1) == 0;
+        }
+    }
+}
+
+void SearchServer::MergeRangeStats(QueryContext &context, size_t range_count) {
+    QueryStats &stats = context.stats_;
+    stats.processed_term_count = stats.term_count;
+    stats.champion_term_count = stats.term_count;
+    for (size_t range = 0; range < range_count; ++range) {
+        const QueryStats &range_stats = context.range_stats_[range];
+        stats.is_exact = stats.is_exact && range_stats.is_exact;
+        stats.processed_term_count = min(stats.processed_term_count, range_stats.processed_term_count);
+        stats.champion_term_count = min(stats.champion_term_count, range_stats.champion_term_count);
+        stats.posting_count += range_stats.posting_count;
+    }
+    stats.is_exact = stats.is_exact && stats.processed_term_count == stats.term_count;
+}
+
+double SearchServer::GetAverageDocumentLength(const QueryContext &context) const {
+    return context.collection_statistics_ == nullptr
+           ? GetAverageDocumentLength()
+           : context.collection_statistics_->average_document_length;
+}
+
+SearchServer::PostingList::const_iterator SearchServer::SkipToPosting(const PostingList &postings,
+                                                                      PostingList::const_iterator cursor,
+                                                                      int document_id) {
+    // std::map не даёт прыгать по позициям, поэтому короткие разрывы проходим по списку,
+    // а длинные - поиском от корня дерева
+    for (size_t step = 0; step < MAX_LINEAR_SKIP_STEPS; ++step) {
+        if (cursor == postings.end() || cursor->first >= document_id) {
+            return cursor;
+        }
+        ++cursor;
+    }
+    return postings.lower_bound(document_id);
+}
+
+SearchServer::PostingList::const_iterator SearchServer::FindFirstPosting(const PostingList &postings, int64_t document_id) {
+    if (document_id > numeric_limits<int>::max()) {
+        return postings.end();
+    }
+    return postings.lower_bound(static_cast<int>(max<int64_t>(document_id, numeric_limits<int>::min())));
+}
+
+SearchServer::ImpactList::const_iterator SearchServer::FindFirstPosting(const ImpactList &impacts, int64_t document_id) {
+    return lower_bound(impacts.begin(), impacts.end(), document_id, [](const ImpactPosting &posting, int64_t id) {
+        return posting.document_id < id;
+    });
+}
+
+SearchServer::ChampionPostings::const_iterator SearchServer::FindFirstPosting(const ChampionPostings &postings,
+                                                                              int64_t document_id) {
+    return lower_bound(postings.begin(), postings.end(), document_id, [](const ChampionPosting &posting, int64_t id) {
+        return posting.document_id < id;
+    });
 }
 //----------------------------------------------------------------------------------------------------------------------
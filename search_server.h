@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -12,17 +13,95 @@
 #include <execution>
 #include <deque>
 #include <type_traits>
+#include <memory>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <typeinfo>
+#include <chrono>
+#include <utility>
 
 #include "document.h"
 #include "string_processing.h"
-#include "concurrent_map.h"
+#include "thread_pool.h"
+#include "memory_usage.h"
+#include "forward_index.h"
+#include "ranking.h"
+#include "perf_counters.h"
+#include "word_filters.h"
 
 const int MAX_RESULT_DOCUMENT_COUNT = 5;
 
 constexpr float NUMBERS_EQUAL_CHECK = 1e-6;
 
+// параллельный поиск: не меньше стольких позиций индекса на диапазон id документов
+constexpr size_t MIN_POSTINGS_PER_PARALLEL_RANGE = 4096;
+// и не больше стольких диапазонов на поток пула (для балансировки)
+constexpr size_t PARALLEL_RANGES_PER_THREAD = 4;
+
+// пересечение списков слов с "+": сколько позиций пройти по списку, прежде чем искать по дереву
+constexpr size_t MAX_LINEAR_SKIP_STEPS = 8;
+
+// граница диапазона id документов, не достижимая ни одним id
+constexpr int64_t MAX_DOCUMENT_ID_BOUND = static_cast<int64_t>(std::numeric_limits<int>::max()) + 1;
+
+// запрос с обязательными словами и сроком: как часто проверять время при обходе самого короткого списка
+constexpr size_t DEADLINE_CHECK_INTERVAL = 1024;
+
+// Списки чемпионов: у слова, которое встречается хотя бы в CHAMPION_MIN_DOCUMENT_FREQ документах, хранится
+// CHAMPION_LIST_SIZE документов с наибольшей долей слова. Список перестраивается, когда вырастет или
+// уменьшится вдвое, и удаляется, когда слово станет вдвое реже порога.
+constexpr size_t CHAMPION_MIN_DOCUMENT_FREQ = 2048;
+constexpr size_t CHAMPION_LIST_SIZE = 256;
+
+// Ограничение на работу одного запроса (QueryContext::SetBudget). Слова запроса обрабатываются
+// от самого редкого (с наибольшим весом) и целиком: проверка бюджета - между словами. Срок перед каждым
+// словом проверяется один раз, и параллельная версия обрабатывает одни и те же слова во всех диапазонах.
+struct QueryBudget {
+    using Clock = std::chrono::steady_clock;
+
+    // после этого момента следующие слова не обрабатываются
+    Clock::time_point deadline = Clock::time_point::max();
+    // сколько позиций списков плюс-слов можно обойти; слово, которое не помещается целиком, пропускается
+    // вместе со всеми следующими. Самое редкое слово обрабатывается всегда, даже если его список длиннее.
+    // Минус-слова обрабатываются всегда и не учитываются. В запросе с "+" это число позиций самого короткого
+    // списка обязательных слов, первая из которых обходится всегда.
+    size_t max_postings = std::numeric_limits<size_t>::max();
+
+    bool HasDeadline() const {
+        return deadline != Clock::time_point::max();
+    }
+
+    bool IsLimited() const {
+        return HasDeadline() || max_postings != std::numeric_limits<size_t>::max();
+    }
+};
+
+// Что сделал последний запрос с QueryContext
+struct QueryStats {
+    // false - бюджет кончился: часть слов (или, для запроса с "+", часть документов) не обработана,
+    // или списков чемпионов не хватило, чтобы доказать, что лучшие документы те же, что по полным спискам
+    bool is_exact = true;
+    // плюс-слов из индекса и сколько из них обработано
+    size_t term_count = 0;
+    size_t processed_term_count = 0;
+    // обойдено позиций списков плюс-слов (для запроса с "+" - самого короткого списка)
+    size_t posting_count = 0;
+    // сколько плюс-слов обработано по спискам чемпионов вместо полных списков
+    size_t champion_term_count = 0;
+};
+
+// Порядок выдачи: по убыванию релевантности, при равной (с точностью NUMBERS_EQUAL_CHECK) - по убыванию рейтинга,
+// затем по возрастанию id
+bool IsMoreRelevant(const Document &lhs, const Document &rhs);
+
 class SearchServer {
 public:
+    using DocumentIds = IndexSet<int, IndexStructure::DOCUMENT_IDS>;
+
+    // Буферы одного запроса, переиспользуемые между запросами (см. ниже)
+    class QueryContext;
+
     SearchServer() = default;
 
     template<typename StringContainer>
@@ -41,21 +120,59 @@ public:
     void RemoveDocument(ExecutionPolicy policy, int document_id);
     //------------------------------------------------------------------------------------------------------------------
 
+    // RankingModel - модель ранжирования из ranking.h, по умолчанию TF-IDF:
+    // search_server.FindTopDocuments<Bm25Ranking>(std::execution::par, raw_query)
+    // Слово с "+" обязательно: "+cat +collar dog" - документы с cat и collar, dog только добавляет релевантность.
+    // Частые слова запроса без "+" с TF-IDF сначала ищутся по спискам чемпионов; если по ним нельзя доказать,
+    // что лучшие документы найдены, запрос пересчитывается по полным спискам (если на это не хватает бюджета,
+    // остаётся результат по спискам чемпионов, помеченный неточным)
+    std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
+
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
+
+    template<typename RankingModel>
     std::vector<Document> FindTopDocuments(std::string_view raw_query) const;
 
+    template<typename RankingModel>
     std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentStatus status) const;
 
-    template<typename DocumentPredicate>
+    template<typename RankingModel = TfIdfRanking, typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(std::string_view raw_query,DocumentPredicate document_predicate) const;
 
-    template<typename ExecutionPolicy>
+    template<typename RankingModel = TfIdfRanking, typename ExecutionPolicy>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const;
 
-    template<typename ExecutionPolicy>
+    template<typename RankingModel = TfIdfRanking, typename ExecutionPolicy>
     std::vector<Document>FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const;
 
-    template<typename ExecutionPolicy, typename DocumentPredicate>
+    template<typename RankingModel = TfIdfRanking, typename ExecutionPolicy, typename DocumentPredicate>
     std::vector<Document> FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query,DocumentPredicate document_predicate) const;
+
+    // Без выделений памяти после прогрева context; результат живёт в context до следующего запроса с ним.
+    // Версии без context используют контекст текущего потока и копируют из него результат. Этот контекст
+    // не реентерабелен: предикат не должен сам вызывать FindTopDocuments без context - вложенный запрос
+    // затрёт буферы внешнего. Во вложенном запросе нужен свой QueryContext.
+    template<typename RankingModel = TfIdfRanking>
+    const std::vector<Document> &FindTopDocuments(QueryContext &context, std::string_view raw_query,
+                                                  DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    template<typename RankingModel = TfIdfRanking, typename DocumentPredicate>
+    const std::vector<Document> &FindTopDocuments(QueryContext &context, std::string_view raw_query,
+                                                  DocumentPredicate document_predicate) const;
+
+    // То же с политикой: бюджет и статистика context действуют и для параллельной версии
+    template<typename RankingModel = TfIdfRanking, typename ExecutionPolicy>
+    const std::vector<Document> &FindTopDocuments(ExecutionPolicy policy, QueryContext &context, std::string_view raw_query,
+                                                  DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    template<typename RankingModel = TfIdfRanking, typename ExecutionPolicy, typename DocumentPredicate>
+    const std::vector<Document> &FindTopDocuments(ExecutionPolicy policy, QueryContext &context, std::string_view raw_query,
+                                                  DocumentPredicate document_predicate) const;
+
+    // Заранее считает вклад каждой пары (слово, документ) для RankingModel: поиск с этой моделью
+    // сводится к сложению. Результаты те же, что без предрасчёта. Сбрасывается AddDocument/RemoveDocument.
+    template<typename RankingModel>
+    void PrecomputeImpacts();
     //------------------------------------------------------------------------------------------------------------------
 
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(std::string_view raw_query, int document_id) const;
@@ -64,39 +181,153 @@ public:
     std::tuple<std::vector<std::string_view>, DocumentStatus> MatchDocument(ExecutionPolicy policy, std::string_view raw_query, int document_id) const;
     //------------------------------------------------------------------------------------------------------------------
 
-    std::set<int>::const_iterator begin() const;
+    DocumentIds::const_iterator begin() const;
 
-    std::set<int>::const_iterator end() const;
+    DocumentIds::const_iterator end() const;
     //------------------------------------------------------------------------------------------------------------------
     int GetDocumentCount() const;
 
-    const std::map<std::string_view, double> &GetWordFrequencies(int document_id) const;
+    double GetAverageDocumentLength() const;
+
+    // Число слов документа без стоп-слов; 0 для неизвестного id
+    uint32_t GetDocumentLength(int document_id) const;
+
+    // Слова документа в порядке term_id, без копирования; для неизвестного id - пустое представление
+    WordFrequenciesView GetWordFrequencies(int document_id) const;
+
+    // O(1), кроме обхода стоп-слов; можно опрашивать из экспортёра метрик
+    MemoryUsage GetMemoryUsage() const;
+
+    //------------------------------------------------------------------------------------------------------------------
+
+    // Все параллельные версии методов (std::execution::par) выполняются на этом пуле.
+    // По умолчанию - общий пул процесса ThreadPool::GetDefault()
+    void SetThreadPool(std::shared_ptr<ThreadPool> thread_pool);
+
+    ThreadPool &GetThreadPool() const;
+
+    // Сколько элементов (слов запроса, слов документа) обрабатывает одна задача пула
+    void SetParallelGrainSize(size_t grain_size);
     //------------------------------------------------------------------------------------------------------------------
 private:
     struct QueryWord {
         std::string_view data;
         bool is_minus;
+        bool is_required;
         bool is_stop;
     };
 
     struct Query {
+        // включая обязательные слова
         std::vector<std::string_view> plus_words;
+        std::vector<std::string_view> required_words;
         std::vector<std::string_view> minus_words;
     };
 
     struct DocumentData {
         int rating;
         DocumentStatus status;
+        // номер ячейки документа в аккумуляторах QueryContext
+        uint32_t ordinal;
+        uint32_t word_count;
+        // записи документа в forward_index_
+        uint32_t forward_size;
+        size_t forward_offset;
     };
 
-    std::set<int> document_ids_;
-    std::map<int, DocumentData> documents_;
-    std::map<std::string_view, std::map<int, double>> word_to_document_freqs_;
-    std::map<int, std::map<std::string_view, double>> document_to_word_freqs_;
+    using PostingList = IndexMap<int, double, IndexStructure::WORD_TO_DOCUMENT_FREQS>;
 
-    std::set<std::string, std::less<>> all_words_;
+    struct ImpactPosting {
+        int document_id;
+        double impact;
+    };
+    using ImpactList = IndexVector<ImpactPosting, IndexStructure::IMPACTS>;
+
+    struct ChampionPosting {
+        int document_id;
+        double term_freq;
+    };
+    using ChampionPostings = IndexVector<ChampionPosting, IndexStructure::CHAMPIONS>;
+
+    struct ChampionList {
+        // по возрастанию id
+        ChampionPostings postings;
+        // доля слова в любом документе со словом, не попавшем в postings, не больше этой
+        double max_other_term_freq = 0.0;
+    };
+
+    struct TermPostings {
+        const PostingList *postings;
+        const ImpactList *impacts; // nullptr, если вклады не посчитаны для текущей модели
+        const ChampionList *champions; // не nullptr - вместо postings обходится список чемпионов
+        double weight;
+    };
+    using WordString = IndexString<IndexStructure::ALL_WORDS>;
+
+    // K-я по убыванию из добавленных релевантностей, K = MAX_RESULT_DOCUMENT_COUNT
+    class TopRelevances {
+    public:
+        void Add(double relevance) {
+            if (size_ < relevances_.size()) {
+                ++size_;
+            } else if (relevance <= relevances_.back()) {
+                return;
+            }
+            size_t i = size_ - 1;
+            for (; i > 0 && relevances_[i - 1] < relevance; --i) {
+                relevances_[i] = relevances_[i - 1];
+            }
+            relevances_[i] = relevance;
+        }
+
+        // -infinity, пока добавлено меньше K
+        double GetLowest() const {
+            return size_ < relevances_.size() ? -std::numeric_limits<double>::infinity() : relevances_.back();
+        }
+
+    private:
+        std::array<double, MAX_RESULT_DOCUMENT_COUNT> relevances_{};
+        size_t size_ = 0;
+    };
+
+    DocumentIds document_ids_;
+    IndexMap<int, DocumentData, IndexStructure::DOCUMENTS> documents_;
+    IndexMap<std::string_view, PostingList, IndexStructure::WORD_TO_DOCUMENT_FREQS> word_to_document_freqs_;
+    // прямой индекс: записи всех документов подряд, удалённые остаются дырами до CompactForwardIndex
+    IndexVector<ForwardIndexEntry, IndexStructure::DOCUMENT_TO_WORD_FREQS> forward_index_;
+    size_t forward_index_garbage_ = 0;
+
+    // слово -> term_id и обратно; слова из словаря не удаляются, поэтому id стабильны
+    IndexMap<WordString, uint32_t, IndexStructure::ALL_WORDS, std::less<>> all_words_;
+    IndexVector<std::string_view, IndexStructure::ALL_WORDS> term_words_;
 
     const std::set<std::string, std::less<>> stop_words_;
+    const StopWordTable stop_word_table_{stop_words_};
+    // все слова all_words_: отсекает слова не из индекса без обхода деревьев
+    VocabularyFilter vocabulary_filter_;
+
+    // для GetMemoryUsage: число пар (слово, документ) и память строк all_words_ вне SSO
+    size_t posting_count_ = 0;
+    size_t all_words_heap_size_ = 0;
+
+    // сумма длин документов (без стоп-слов) для средней длины в BM25
+    uint64_t total_word_count_ = 0;
+
+    // номера документов плотные: освобождённые при удалении раздаются заново
+    uint32_t ordinal_count_ = 0;
+    std::vector<uint32_t> free_ordinals_;
+
+    // вклады, посчитанные PrecomputeImpacts для модели impacts_model_
+    IndexMap<std::string_view, ImpactList, IndexStructure::IMPACTS> impacts_;
+    const std::type_info *impacts_model_ = nullptr;
+    size_t impacts_size_ = 0;
+
+    // списки чемпионов частых слов и оценка их памяти
+    IndexMap<std::string_view, ChampionList, IndexStructure::CHAMPIONS> champion_lists_;
+    size_t champion_lists_size_ = 0;
+
+    std::shared_ptr<ThreadPool> thread_pool_;
+    size_t parallel_grain_size_ = 1;
 private:
     //------------------------------------------------------------------------------------------------------------------
 
@@ -110,24 +341,239 @@ private:
     QueryWord ParseQueryWord(std::string_view text) const;
 
     Query ParseQuery(std::string_view text, bool is_parallel = false) const;
+
+    void ParseQuery(std::string_view text, bool is_parallel, std::vector<std::string_view> &words, Query &result) const;
     //------------------------------------------------------------------------------------------------------------------
 
     static int ComputeAverageRating(const std::vector<int> &ratings);
 
-    double ComputeWordInverseDocumentFreq(std::string_view word) const;
+    void CompactForwardIndex();
+
+    void ResetImpacts();
+
+    // Обновляют список чемпионов слова после добавления документа в postings или удаления из него
+    void AddChampionPosting(std::string_view word, const PostingList &postings, int document_id);
+
+    void RemoveChampionPosting(std::string_view word, const PostingList &postings, int document_id);
+
+    void BuildChampionList(const PostingList &postings, ChampionList &champions);
+
+    uint32_t AcquireOrdinal();
+
+    static QueryContext &GetThreadQueryContext();
+
+    static void KeepTopDocuments(std::vector<Document> &matched_documents);
+
+    template<typename RankingModel>
+    double ComputeTermWeight(size_t document_freq) const;
     //------------------------------------------------------------------------------------------------------------------
 
-    template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const Query &query,DocumentPredicate document_predicate) const;
+    template<typename RankingModel>
+    void GetPlusTerms(QueryContext &context) const;
+
+    // nullptr - слова нет в индексе
+    const PostingList *FindPostingList(std::string_view word) const;
+
+    // Список слова для запроса с context. Слово, которого нет во внешней статистике context (документ с ним
+    // добавлен после снимка), считается отсутствующим: с нулевой частотой вес слова не определён
+    const PostingList *FindPostingList(const QueryContext &context, std::string_view word) const;
+
+    // nullptr - у слова нет списка чемпионов
+    const ChampionList *FindChampionList(std::string_view word) const;
+
+    void GetMinusTerms(const Query &query, std::vector<const PostingList *> &minus_terms) const;
+
+    // Списки обязательных слов в context.required_terms_, от самого короткого; false - какого-то слова нет в индексе
+    bool GetRequiredTerms(QueryContext &context) const;
+
+    double GetAverageDocumentLength(const QueryContext &context) const;
+
+    // Оставляет списки чемпионов плюс-слов, если запрос без обязательных слов, и считает context.champion_bound_
+    static void SelectChampionLists(QueryContext &context);
+
+    // Проверяет найденное по спискам чемпионов. false - лучшие документы могут отличаться, а бюджет позволяет
+    // пересчёт: списки чемпионов выключены, и запрос нужно пересчитать по полным спискам
+    static bool KeepChampionResult(QueryContext &context);
+
+    static size_t GetScannedPostingCount(const TermPostings &term);
+
+    // Сбрасывает context.stats_ и по context.budget_ упорядочивает плюс-слова и ограничивает их число
+    void ApplyBudget(QueryContext &context) const;
+
+    // Обрабатывать ли слово term_index при сроке. Решение по слову принимает первый дошедший до него диапазон,
+    // остальные его повторяют
+    static bool IsTermWithinDeadline(QueryContext &context, size_t term_index);
+
+    // Собирает context.stats_ из статистики диапазонов
+    static void MergeRangeStats(QueryContext &context, size_t range_count);
+
+    static PostingList::const_iterator FindFirstPosting(const PostingList &postings, int64_t document_id);
 
-    template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::sequenced_policy& policy, const Query &query,DocumentPredicate document_predicate) const;
+    // Первая позиция не раньше cursor с id >= document_id
+    static PostingList::const_iterator SkipToPosting(const PostingList &postings, PostingList::const_iterator cursor,
+                                                     int document_id);
 
-    template<typename DocumentPredicate>
-    std::vector<Document> FindAllDocuments(const std::execution::parallel_policy& policy, const Query &query,DocumentPredicate document_predicate) const;
+    static ImpactList::const_iterator FindFirstPosting(const ImpactList &impacts, int64_t document_id);
+
+    static ChampionPostings::const_iterator FindFirstPosting(const ChampionPostings &postings, int64_t document_id);
+
+    // Релевантность документа по первым term_count плюс-словам, по полным спискам и в порядке слов
+    template<typename RankingModel>
+    double ComputeDocumentRelevance(const QueryContext &context, size_t term_count, int document_id,
+                                    const DocumentData &document_data, double average_document_length) const;
+
+    // Считает релевантность документов с id из [lower_id, upper_id) и пишет их в context.range_documents_[range]
+    // по возрастанию id. Диапазоны разных вызовов не должны пересекаться: аккумуляторы context у них общие.
+    template<typename RankingModel, typename DocumentPredicate>
+    void ScoreDocumentRange(QueryContext &context, size_t range, int64_t lower_id, int64_t upper_id,
+                            DocumentPredicate document_predicate) const;
+
+    // То же для запроса с обязательными словами: пересекает их списки и считает релевантность только
+    // для документов из пересечения, поиском в списках остальных слов
+    template<typename RankingModel, typename DocumentPredicate>
+    void ScoreIntersectionRange(QueryContext &context, size_t range, int64_t lower_id, int64_t upper_id,
+                                DocumentPredicate document_predicate) const;
+
+    // Разбирает запрос и пишет найденные документы в context.matched_documents_ по возрастанию id
+    // (со списками чемпионов - только те, что могут попасть в топ)
+    template<typename RankingModel, typename DocumentPredicate>
+    void FindAllDocuments(QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template<typename RankingModel, typename DocumentPredicate>
+    void FindAllDocuments(const std::execution::sequenced_policy& policy, QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const;
+
+    template<typename RankingModel, typename DocumentPredicate>
+    void FindAllDocuments(const std::execution::parallel_policy& policy, QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const;
     //------------------------------------------------------------------------------------------------------------------
 };
 
+// Буферы запроса: слова, разобранный запрос, аккумуляторы релевантности и результат.
+// Один контекст - один запрос в момент времени; можно переиспользовать между разными серверами.
+class SearchServer::QueryContext {
+public:
+    QueryContext() = default;
+
+    QueryContext(const QueryContext &) = delete;
+
+    QueryContext &operator=(const QueryContext &) = delete;
+
+    // Веса слов и средняя длина документа берутся из statistics вместо индекса сервера (nullptr - из индекса).
+    // statistics должна жить, пока идут запросы с этим контекстом.
+    void SetCollectionStatistics(const CollectionStatistics *statistics) {
+        collection_statistics_ = statistics;
+    }
+
+    // Бюджет для следующего запроса с этим контекстом; запрос его забирает, и последующие идут без ограничений,
+    // пока бюджет не задан снова (срок - момент времени, поэтому задаётся перед каждым запросом).
+    // С бюджетом слова складываются в другом порядке, поэтому релевантность может отличаться
+    // от запроса без бюджета в последних битах.
+    void SetBudget(const QueryBudget &budget) {
+        next_budget_ = budget;
+    }
+
+    const QueryStats &GetStats() const {
+        return stats_;
+    }
+
+private:
+    friend class SearchServer;
+
+    struct TouchedDocument {
+        int document_id;
+        uint32_t ordinal;
+    };
+
+    enum class AccumulatorState : uint8_t {
+        EMPTY,
+        ACTIVE,
+        EXCLUDED,
+    };
+
+    // Возвращает затронутые документы диапазона в EMPTY, если обход прерван исключением (например, из предиката):
+    // иначе они остались бы ACTIVE, и следующие запросы с этим контекстом их пропускали бы.
+    class TouchedStatesGuard {
+    public:
+        TouchedStatesGuard(std::vector<AccumulatorState> &states, const std::vector<TouchedDocument> &touched)
+                : states_(states), touched_(touched) {
+        }
+
+        TouchedStatesGuard(const TouchedStatesGuard &) = delete;
+
+        TouchedStatesGuard &operator=(const TouchedStatesGuard &) = delete;
+
+        ~TouchedStatesGuard() {
+            if (active_) {
+                for (const TouchedDocument &document : touched_) {
+                    states_[document.ordinal] = AccumulatorState::EMPTY;
+                }
+            }
+        }
+
+        // состояния уже сброшены обычным путём
+        void Release() {
+            active_ = false;
+        }
+
+    private:
+        std::vector<AccumulatorState> &states_;
+        const std::vector<TouchedDocument> &touched_;
+        bool active_ = true;
+    };
+
+    std::vector<std::string_view> words_;
+    Query query_;
+    std::vector<TermPostings> plus_terms_;
+    std::vector<const PostingList *> minus_terms_;
+    std::vector<const PostingList *> required_terms_;
+    const CollectionStatistics *collection_statistics_ = nullptr;
+    // обходятся списки чемпионов; документ, не попавший ни в один обойдённый список, набирает не больше
+    // champion_bound_, а попавший - не больше накопленного плюс champion_bound_
+    bool use_champions_ = false;
+    double champion_bound_ = 0.0;
+
+    // заданный SetBudget и действующий в текущем запросе
+    QueryBudget next_budget_;
+    QueryBudget budget_;
+    QueryStats stats_;
+    // решения по сроку, общие для диапазонов: число слов, которые решено обработать, сдвинутое на бит,
+    // и младший бит - срок наступил перед следующим словом
+    std::atomic<size_t> deadline_decision_ = 0;
+    // сколько первых plus_terms_ разрешает max_postings
+    size_t term_limit_ = 0;
+    // запрос с "+": граница id, до которой max_postings разрешает обойти самый короткий список
+    int64_t intersection_upper_id_ = MAX_DOCUMENT_ID_BOUND;
+
+    // аккумуляторы по номеру документа; между запросами все состояния EMPTY
+    std::vector<double> relevances_;
+    std::vector<AccumulatorState> states_;
+    // затронутые документы и найденные документы по диапазонам id
+    std::vector<std::vector<TouchedDocument>> range_touched_;
+    std::vector<std::vector<Document>> range_documents_;
+    // позиции в списках обязательных слов (кроме самого короткого) по диапазонам id
+    std::vector<std::vector<PostingList::const_iterator>> range_cursors_;
+    std::vector<QueryStats> range_stats_;
+
+    std::vector<Document> matched_documents_;
+
+    void TakeBudget() {
+        budget_ = std::exchange(next_budget_, QueryBudget{});
+    }
+
+    void Prepare(size_t ordinal_count, size_t range_count) {
+        if (relevances_.size() < ordinal_count) {
+            relevances_.resize(ordinal_count);
+            states_.resize(ordinal_count, AccumulatorState::EMPTY);
+        }
+        if (range_touched_.size() < range_count) {
+            range_touched_.resize(range_count);
+            range_documents_.resize(range_count);
+            range_cursors_.resize(range_count);
+            range_stats_.resize(range_count);
+        }
+        matched_documents_.clear();
+    }
+};
+
 //Methods with template:
 //----------------------------------------------------------------------------------------------------------------------
 template<typename StringContainer>
@@ -137,149 +583,409 @@ SearchServer::SearchServer(const StringContainer &stop_words) : stop_words_(Make
     }
 }
 //----------------------------------------------------------------------------------------------------------------------
-template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
-    const Query query = ParseQuery(raw_query, false);
+template<typename RankingModel>
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query) const {
+    return FindTopDocuments<RankingModel>(raw_query, DocumentStatus::ACTUAL);
+}
+
+template<typename RankingModel>
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments<RankingModel>(raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
 
-    auto matched_documents = FindAllDocuments(std::execution::seq, query, document_predicate);
+template<typename RankingModel, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const {
+    return FindTopDocuments<RankingModel>(GetThreadQueryContext(), raw_query, document_predicate);
+}
 
-    std::sort(matched_documents.begin(), matched_documents.end(),[](const Document &lhs, const Document &rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < NUMBERS_EQUAL_CHECK) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
-        }
+template<typename RankingModel>
+const std::vector<Document> &SearchServer::FindTopDocuments(QueryContext &context, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments<RankingModel>(context, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
     });
+}
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
-    }
+template<typename RankingModel, typename DocumentPredicate>
+const std::vector<Document> &SearchServer::FindTopDocuments(QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    FindAllDocuments<RankingModel>(std::execution::seq, context, raw_query, document_predicate);
+    KeepTopDocuments(context.matched_documents_);
+    return context.matched_documents_;
+}
 
-    return matched_documents;
+template<typename RankingModel, typename ExecutionPolicy>
+const std::vector<Document> &SearchServer::FindTopDocuments(ExecutionPolicy policy, QueryContext &context, std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments<RankingModel>(policy, context, raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
 }
 
-template<typename ExecutionPolicy, typename DocumentPredicate>
-std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query,DocumentPredicate document_predicate) const {
+template<typename RankingModel, typename ExecutionPolicy, typename DocumentPredicate>
+const std::vector<Document> &SearchServer::FindTopDocuments(ExecutionPolicy policy, QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const {
     if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
-        return FindTopDocuments(raw_query, document_predicate);
+        return FindTopDocuments<RankingModel>(context, raw_query, document_predicate);
     }
 
-    const Query query = ParseQuery(raw_query, false);
-
-    std::vector<Document> matched_documents = FindAllDocuments(policy, query, document_predicate);
-
-    std::sort(policy, matched_documents.begin(), matched_documents.end(),[](const Document &lhs, const Document &rhs) {
-        if (std::abs(lhs.relevance - rhs.relevance) < NUMBERS_EQUAL_CHECK) {
-            return lhs.rating > rhs.rating;
-        } else {
-            return lhs.relevance > rhs.relevance;
-        }
-    });
+    FindAllDocuments<RankingModel>(policy, context, raw_query, document_predicate);
+    KeepTopDocuments(context.matched_documents_);
+    return context.matched_documents_;
+}
 
-    if (matched_documents.size() > MAX_RESULT_DOCUMENT_COUNT) {
-        matched_documents.resize(MAX_RESULT_DOCUMENT_COUNT);
+template<typename RankingModel, typename ExecutionPolicy, typename DocumentPredicate>
+std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query,DocumentPredicate document_predicate) const {
+    if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
+        return FindTopDocuments<RankingModel>(raw_query, document_predicate);
     }
 
-    return matched_documents;
+    QueryContext &context = GetThreadQueryContext();
+    FindAllDocuments<RankingModel>(policy, context, raw_query, document_predicate);
+    KeepTopDocuments(context.matched_documents_);
+    return context.matched_documents_;
 }
 
-
-template<typename ExecutionPolicy>
+template<typename RankingModel, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query) const {
-    return FindTopDocuments(policy, raw_query, DocumentStatus::ACTUAL);
+    return FindTopDocuments<RankingModel>(policy, raw_query, DocumentStatus::ACTUAL);
 }
 
-template<typename ExecutionPolicy>
+template<typename RankingModel, typename ExecutionPolicy>
 std::vector<Document> SearchServer::FindTopDocuments(ExecutionPolicy policy, std::string_view raw_query, DocumentStatus status) const {
-    return FindTopDocuments(policy, raw_query,[status](int document_id, DocumentStatus document_status, int rating) {
+    return FindTopDocuments<RankingModel>(policy, raw_query,[status](int, DocumentStatus document_status, int) {
         return document_status == status;
     });
 }
 //----------------------------------------------------------------------------------------------------------------------
+template<typename RankingModel>
+void SearchServer::PrecomputeImpacts() {
+    impacts_.clear();
+    impacts_size_ = 0;
+    const double average_document_length = GetAverageDocumentLength();
+    for (const auto &[word, postings] : word_to_document_freqs_) {
+        const double term_weight = ComputeTermWeight<RankingModel>(postings.size());
+        ImpactList &impacts = impacts_[word];
+        impacts.reserve(postings.size());
+        for (const auto [document_id, term_freq] : postings) {
+            const uint32_t document_length = documents_.at(document_id).word_count;
+            impacts.push_back({document_id, RankingModel::ComputeScore(term_freq, term_weight, document_length, average_document_length)});
+        }
+        impacts_size_ += EstimateAllocationSize(impacts.capacity() * sizeof(ImpactPosting));
+    }
+    impacts_model_ = &typeid(RankingModel);
+}
 
-template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const Query &query, DocumentPredicate document_predicate) const {
-    std::map<int, double> document_to_relevance;
+template<typename RankingModel>
+double SearchServer::ComputeTermWeight(size_t document_freq) const {
+    return RankingModel::ComputeTermWeight(GetDocumentCount(), document_freq);
+}
 
-    for (std::string_view word: query.plus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
+template<typename RankingModel>
+void SearchServer::GetPlusTerms(QueryContext &context) const {
+    const CollectionStatistics *statistics = context.collection_statistics_;
+    // вклады посчитаны по статистике этого сервера и с внешней статистикой не годятся
+    const bool has_impacts = statistics == nullptr && impacts_model_ != nullptr && *impacts_model_ == typeid(RankingModel);
+    context.plus_terms_.clear();
+    for (std::string_view word : context.query_.plus_words) {
+        const PostingList *postings = FindPostingList(context, word);
+        if (postings == nullptr) {
             continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq]: word_to_document_freqs_.find(word)->second) {
+        const ImpactList *impacts = has_impacts ? &impacts_.at(word) : nullptr;
+        // граница вклада документов вне списка чемпионов верна, только пока вклад растёт с долей слова
+        // и не зависит от длины документа
+        const ChampionList *champions = std::is_same_v<RankingModel, TfIdfRanking> ? FindChampionList(word) : nullptr;
+        const double weight = statistics == nullptr
+                              ? ComputeTermWeight<RankingModel>(postings->size())
+                              : RankingModel::ComputeTermWeight(statistics->document_count, statistics->GetDocumentFreq(word));
+        context.plus_terms_.push_back({postings, impacts, champions, weight});
+    }
+}
+
+template<typename RankingModel, typename DocumentPredicate>
+void SearchServer::ScoreDocumentRange(QueryContext &context, size_t range, int64_t lower_id, int64_t upper_id,
+                                      DocumentPredicate document_predicate) const {
+    if (!context.required_terms_.empty()) {
+        ScoreIntersectionRange<RankingModel>(context, range, lower_id, upper_id, document_predicate);
+        return;
+    }
+    using AccumulatorState = QueryContext::AccumulatorState;
+    const double average_document_length = GetAverageDocumentLength(context);
+    std::vector<QueryContext::TouchedDocument> &touched = context.range_touched_[range];
+    touched.clear();
+    QueryContext::TouchedStatesGuard touched_states_guard(context.states_, touched);
+    QueryStats &range_stats = context.range_stats_[range];
+    range_stats = QueryStats{};
+    const bool has_deadline = context.budget_.HasDeadline();
+
+    auto accumulate = [&](int document_id, const DocumentData &document_data, double relevance) {
+        AccumulatorState &state = context.states_[document_data.ordinal];
+        if (state == AccumulatorState::EMPTY) {
+            state = AccumulatorState::ACTIVE;
+            context.relevances_[document_data.ordinal] = 0.0;
+            touched.push_back({document_id, document_data.ordinal});
+        }
+        context.relevances_[document_data.ordinal] += relevance;
+    };
+
+    for (size_t term_index = 0; term_index < context.term_limit_; ++term_index) {
+        if (has_deadline && !IsTermWithinDeadline(context, term_index)) {
+            break;
+        }
+        const TermPostings &term = context.plus_terms_[term_index];
+        ++range_stats.processed_term_count;
+        if (term.champions != nullptr) {
+            ++range_stats.champion_term_count;
+            const auto champions_end = FindFirstPosting(term.champions->postings, upper_id);
+            for (auto it = FindFirstPosting(term.champions->postings, lower_id); it != champions_end; ++it) {
+                ++range_stats.posting_count;
+                const DocumentData &document_data = documents_.at(it->document_id);
+                if (document_predicate(it->document_id, document_data.status, document_data.rating)) {
+                    accumulate(it->document_id, document_data, RankingModel::ComputeScore(it->term_freq, term.weight, document_data.word_count, average_document_length));
+                }
+            }
+            continue;
+        }
+        if (term.impacts != nullptr) {
+            const auto impacts_end = FindFirstPosting(*term.impacts, upper_id);
+            for (auto it = FindFirstPosting(*term.impacts, lower_id); it != impacts_end; ++it) {
+                ++range_stats.posting_count;
+                const DocumentData &document_data = documents_.at(it->document_id);
+                if (document_predicate(it->document_id, document_data.status, document_data.rating)) {
+                    accumulate(it->document_id, document_data, it->impact);
+                }
+            }
+            continue;
+        }
+        const auto postings_end = FindFirstPosting(*term.postings, upper_id);
+        for (auto it = FindFirstPosting(*term.postings, lower_id); it != postings_end; ++it) {
+            ++range_stats.posting_count;
+            const auto [document_id, term_freq] = *it;
             const DocumentData &document_data = documents_.at(document_id);
             if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id] += term_freq * inverse_document_freq;
+                accumulate(document_id, document_data, RankingModel::ComputeScore(term_freq, term.weight, document_data.word_count, average_document_length));
             }
         }
     }
 
-    for (std::string_view word: query.minus_words) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            continue;
-        }
-        for (const auto [document_id, _]: word_to_document_freqs_.find(word)->second) {
-            document_to_relevance.erase(document_id);
+    for (const PostingList *postings : context.minus_terms_) {
+        const auto postings_end = FindFirstPosting(*postings, upper_id);
+        for (auto it = FindFirstPosting(*postings, lower_id); it != postings_end; ++it) {
+            AccumulatorState &state = context.states_[documents_.at(it->first).ordinal];
+            if (state == AccumulatorState::ACTIVE) {
+                state = AccumulatorState::EXCLUDED;
+            }
         }
     }
 
-    std::vector<Document> matched_documents;
-    for (const auto& [document_id, relevance] : document_to_relevance) {
-        matched_documents.emplace_back(document_id, relevance, documents_.at(document_id).rating);
+    // Со списками чемпионов накоплена только часть вклада частых слов. Документ войдёт в топ, только если
+    // накопленное плюс champion_bound_ не меньше K-й накопленной релевантности диапазона; таким документам
+    // релевантность досчитывается по полным спискам. Запас в два NUMBERS_EQUAL_CHECK покрывает разный
+    // порядок сложения: отброшенный документ менее релевантен любого из K и по IsMoreRelevant.
+    double champion_threshold = 0.0;
+    if (context.use_champions_) {
+        TopRelevances top_relevances;
+        for (const auto [document_id, ordinal] : touched) {
+            if (context.states_[ordinal] == AccumulatorState::ACTIVE) {
+                top_relevances.Add(context.relevances_[ordinal]);
+            }
+        }
+        champion_threshold = top_relevances.GetLowest() - 2 * NUMBERS_EQUAL_CHECK;
     }
-    return matched_documents;
-}
 
-template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::sequenced_policy& policy, const Query &query,DocumentPredicate document_predicate) const {
-    return FindAllDocuments(query, document_predicate);
+    std::sort(touched.begin(), touched.end(), [](const auto &lhs, const auto &rhs) {
+        return lhs.document_id < rhs.document_id;
+    });
+    std::vector<Document> &matched_documents = context.range_documents_[range];
+    matched_documents.clear();
+    for (const auto [document_id, ordinal] : touched) {
+        if (context.states_[ordinal] == AccumulatorState::ACTIVE) {
+            const DocumentData &document_data = documents_.at(document_id);
+            if (!context.use_champions_) {
+                matched_documents.emplace_back(document_id, context.relevances_[ordinal], document_data.rating);
+            } else if (context.relevances_[ordinal] + context.champion_bound_ > champion_threshold) {
+                matched_documents.emplace_back(document_id,
+                                               ComputeDocumentRelevance<RankingModel>(context, range_stats.processed_term_count, document_id,
+                                                                                      document_data, average_document_length),
+                                               document_data.rating);
+            }
+        }
+        context.states_[ordinal] = AccumulatorState::EMPTY;
+    }
+    touched_states_guard.Release();
 }
 
-template<typename DocumentPredicate>
-std::vector<Document> SearchServer::FindAllDocuments(const std::execution::parallel_policy& policy, const Query &query, DocumentPredicate document_predicate) const {
-    ConcurrentMap<int, double> document_to_relevance(20000);
+template<typename RankingModel, typename DocumentPredicate>
+void SearchServer::ScoreIntersectionRange(QueryContext &context, size_t range, int64_t lower_id, int64_t upper_id,
+                                          DocumentPredicate document_predicate) const {
+    const double average_document_length = GetAverageDocumentLength(context);
+    const std::vector<const PostingList *> &required_terms = context.required_terms_;
+    std::vector<PostingList::const_iterator> &cursors = context.range_cursors_[range];
+    cursors.clear();
+    for (size_t i = 1; i < required_terms.size(); ++i) {
+        cursors.push_back(FindFirstPosting(*required_terms[i], lower_id));
+    }
+    std::vector<Document> &matched_documents = context.range_documents_[range];
+    matched_documents.clear();
+    QueryStats &range_stats = context.range_stats_[range];
+    range_stats = QueryStats{};
+    range_stats.processed_term_count = context.plus_terms_.size();
+    const bool has_deadline = context.budget_.HasDeadline();
+
+    // идём по самому короткому списку и ищем его документы в остальных, сдвигая курсоры только вперёд;
+    // бюджет ограничивает обход этого списка
+    // диапазон целиком за границей бюджета пуст: конец обхода не должен оказаться раньше начала
+    const auto rarest_end = FindFirstPosting(*required_terms.front(),
+                                             std::max(lower_id, std::min(upper_id, context.intersection_upper_id_)));
+    for (auto it = FindFirstPosting(*required_terms.front(), lower_id); it != rarest_end; ++it) {
+        ++range_stats.posting_count;
+        if (has_deadline && range_stats.posting_count % DEADLINE_CHECK_INTERVAL == 0
+            && QueryBudget::Clock::now() >= context.budget_.deadline) {
+            range_stats.is_exact = false;
+            break;
+        }
+        const int document_id = it->first;
+        bool is_exhausted = false;
+        bool is_intersection = true;
+        for (size_t i = 0; i < cursors.size() && is_intersection; ++i) {
+            cursors[i] = SkipToPosting(*required_terms[i + 1], cursors[i], document_id);
+            is_exhausted = cursors[i] == required_terms[i + 1]->end();
+            is_intersection = !is_exhausted && cursors[i]->first == document_id;
+        }
+        if (is_exhausted) {
+            break;
+        }
+        if (!is_intersection) {
+            continue;
+        }
 
-    std::for_each(policy, query.plus_words.begin(), query.plus_words.end(),[&](const auto &word) {
-        if (word_to_document_freqs_.count(word) == 0) {
-            return;
+        const DocumentData &document_data = documents_.at(document_id);
+        if (!document_predicate(document_id, document_data.status, document_data.rating)
+            || std::any_of(context.minus_terms_.begin(), context.minus_terms_.end(), [document_id](const PostingList *postings) {
+                   return postings->count(document_id) > 0;
+               })) {
+            continue;
         }
-        const double inverse_document_freq = ComputeWordInverseDocumentFreq(word);
-        for (const auto [document_id, term_freq]: word_to_document_freqs_.at(word)) {
-            const DocumentData &document_data = documents_.at(document_id);
-            if (document_predicate(document_id, document_data.status, document_data.rating)) {
-                document_to_relevance[document_id].ref_to_value += term_freq * inverse_document_freq;
+        matched_documents.emplace_back(document_id,
+                                       ComputeDocumentRelevance<RankingModel>(context, context.plus_terms_.size(), document_id,
+                                                                              document_data, average_document_length),
+                                       document_data.rating);
+    }
+}
+
+template<typename RankingModel>
+double SearchServer::ComputeDocumentRelevance(const QueryContext &context, size_t term_count, int document_id,
+                                              const DocumentData &document_data, double average_document_length) const {
+    // слова в том же порядке, что и в ScoreDocumentRange, поэтому релевантность совпадает побитово
+    double relevance = 0.0;
+    for (size_t term_index = 0; term_index < term_count; ++term_index) {
+        const TermPostings &term = context.plus_terms_[term_index];
+        if (term.impacts != nullptr) {
+            const auto impact = FindFirstPosting(*term.impacts, document_id);
+            if (impact != term.impacts->end() && impact->document_id == document_id) {
+                relevance += impact->impact;
             }
+            continue;
+        }
+        const auto posting = term.postings->find(document_id);
+        if (posting != term.postings->end()) {
+            relevance += RankingModel::ComputeScore(posting->second, term.weight, document_data.word_count, average_document_length);
         }
+    }
+    return relevance;
+}
 
-    });
+template<typename RankingModel, typename DocumentPredicate>
+void SearchServer::FindAllDocuments(QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    PERF_SCOPE("SearchServer::FindAllDocuments");
+    context.TakeBudget();
+    ParseQuery(raw_query, false, context.words_, context.query_);
+    GetPlusTerms<RankingModel>(context);
+    GetMinusTerms(context.query_, context.minus_terms_);
+    const bool has_required_terms = GetRequiredTerms(context);
+    SelectChampionLists(context);
+    ApplyBudget(context);
+    context.Prepare(ordinal_count_, 1);
+    if (!has_required_terms) {
+        return;
+    }
 
-    std::for_each(
-            policy,
-            query.minus_words.begin(),query.minus_words.end(),
-            [&](const auto &word) {
-                if (word_to_document_freqs_.count(word) == 0) {
-                    return;
-                }
-                for (const auto [document_id, _]: word_to_document_freqs_.at(word)) {
-                    document_to_relevance.ERASE(document_id);
-                }
-            });
+    auto score_documents = [&] {
+        ScoreDocumentRange<RankingModel>(context, 0, 0, MAX_DOCUMENT_ID_BOUND, document_predicate);
+        MergeRangeStats(context, 1);
+        context.matched_documents_.swap(context.range_documents_[0]);
+    };
+    score_documents();
+    if (context.use_champions_ && !KeepChampionResult(context)) {
+        score_documents();
+    }
+}
 
-    const std::map<int, double> docs(document_to_relevance.BuildOrdinaryMap());
+template<typename RankingModel, typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const std::execution::sequenced_policy&, QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    FindAllDocuments<RankingModel>(context, raw_query, document_predicate);
+}
 
-    std::vector<Document> matched_documents(docs.size());
+template<typename RankingModel, typename DocumentPredicate>
+void SearchServer::FindAllDocuments(const std::execution::parallel_policy&, QueryContext &context, std::string_view raw_query, DocumentPredicate document_predicate) const {
+    // без PERF_SCOPE: счётчики читаются в вызывающем потоке и не увидели бы работу задач пула
+    context.TakeBudget();
+    ParseQuery(raw_query, false, context.words_, context.query_);
+    GetPlusTerms<RankingModel>(context);
+    GetMinusTerms(context.query_, context.minus_terms_);
+    const bool has_required_terms = GetRequiredTerms(context);
+    SelectChampionLists(context);
+    ApplyBudget(context);
+    if (!has_required_terms || context.plus_terms_.empty() || document_ids_.empty()) {
+        context.Prepare(ordinal_count_, 1);
+        return;
+    }
 
-    std::transform(policy, docs.begin(), docs.end(), matched_documents.begin(),
-                   [&](const auto &item) {
-                       return Document({item.first, item.second, documents_.at(item.first).rating});
-                   });
+    // Делим пространство id документов на диапазоны, каждый диапазон обходит все слова запроса.
+    // Внутри диапазона порядок сложения тот же, что и в последовательной версии, поэтому
+    // релевантность совпадает побитово, а склейка диапазонов по порядку даёт тот же порядок документов.
+    // Документ попадает ровно в один диапазон, поэтому общие аккумуляторы context не требуют блокировок.
+    ThreadPool &thread_pool = GetThreadPool();
+    const int64_t first_id = *document_ids_.begin();
+    const int64_t last_id = static_cast<int64_t>(*document_ids_.rbegin()) + 1;
+    auto score_documents = [&] {
+        // с обязательными словами работа определяется самым коротким их списком
+        size_t posting_count = 0;
+        if (context.required_terms_.empty()) {
+            for (const TermPostings &term : context.plus_terms_) {
+                posting_count += GetScannedPostingCount(term);
+            }
+        } else {
+            posting_count = context.required_terms_.front()->size();
+        }
+        const size_t range_count = std::clamp<size_t>(
+                std::min<size_t>(posting_count / MIN_POSTINGS_PER_PARALLEL_RANGE, static_cast<size_t>(last_id - first_id)),
+                1, std::max<size_t>(thread_pool.GetThreadCount(), 1) * PARALLEL_RANGES_PER_THREAD);
+        auto range_bound = [&](size_t range) {
+            return first_id + (last_id - first_id) * static_cast<int64_t>(range) / static_cast<int64_t>(range_count);
+        };
+        context.Prepare(ordinal_count_, range_count);
+
+        thread_pool.ParallelFor(range_count, 1, [&](size_t begin, size_t end) {
+            for (size_t range = begin; range < end; ++range) {
+                ScoreDocumentRange<RankingModel>(context, range, range_bound(range), range_bound(range + 1), document_predicate);
+            }
+        });
 
-    return matched_documents;
+        MergeRangeStats(context, range_count);
+        for (size_t range = 0; range < range_count; ++range) {
+            const std::vector<Document> &documents = context.range_documents_[range];
+            context.matched_documents_.insert(context.matched_documents_.end(), documents.begin(), documents.end());
+        }
+    };
+    score_documents();
+    if (context.use_champions_ && !KeepChampionResult(context)) {
+        score_documents();
+    }
 }
 //----------------------------------------------------------------------------------------------------------------------
 
 template<typename ExecutionPolicy>
-std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy policy, std::string_view raw_query,int document_id) const {
+std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDocument(ExecutionPolicy, std::string_view raw_query,int document_id) const {
     if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
         return MatchDocument(raw_query, document_id);
     }
@@ -293,33 +999,50 @@ std::tuple<std::vector<std::string_view>, DocumentStatus> SearchServer::MatchDoc
     }
 
     const Query query = ParseQuery(raw_query, true);
+    ThreadPool &thread_pool = GetThreadPool();
+
+    auto word_in_document = [this, document_id](std::string_view word) {
+        const PostingList *postings = FindPostingList(word);
+        return postings != nullptr && postings->count(document_id) > 0;
+    };
 
-    if (any_of(policy,query.minus_words.begin(), query.minus_words.end(), [this, document_id](std::string_view word) {
-        return word_to_document_freqs_.count(word) && word_to_document_freqs_.find(word)->second.count(document_id);
-    })) {
+    std::atomic<bool> has_minus_word = false;
+    thread_pool.ParallelFor(query.minus_words.size(), parallel_grain_size_, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end && !has_minus_word.load(std::memory_order_relaxed); ++i) {
+            if (word_in_document(query.minus_words[i])) {
+                has_minus_word = true;
+            }
+        }
+    });
+    if (has_minus_word || !std::all_of(query.required_words.begin(), query.required_words.end(), word_in_document)) {
         return {std::vector<std::string_view>(), documents_.at(document_id).status};
     }
 
-    std::vector<std::string_view> matched_words(query.plus_words.size());
+    std::vector<char> is_matched(query.plus_words.size());
+    thread_pool.ParallelFor(query.plus_words.size(), parallel_grain_size_, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            is_matched[i] = word_in_document(query.plus_words[i]);
+        }
+    });
 
-    auto words_end = copy_if(
-            policy,
-            query.plus_words.begin(), query.plus_words.end(),
-            matched_words.begin(),
-            [this, document_id](std::string_view word) {
-                return word_to_document_freqs_.count(word) && word_to_document_freqs_.find(word)->second.count(document_id);
-            });
+    std::vector<std::string_view> matched_words;
+    for (size_t i = 0; i < query.plus_words.size(); ++i) {
+        if (is_matched[i]) {
+            matched_words.push_back(query.plus_words[i]);
+        }
+    }
 
-    std::sort(policy, matched_words.begin(), words_end);
-    matched_words.erase(unique(matched_words.begin(), words_end), matched_words.end());
+    std::sort(matched_words.begin(), matched_words.end());
+    matched_words.erase(unique(matched_words.begin(), matched_words.end()), matched_words.end());
 
     return {matched_words, documents_.at(document_id).status};
 }
 //----------------------------------------------------------------------------------------------------------------------
 template<typename ExecutionPolicy>
-void SearchServer::RemoveDocument(ExecutionPolicy policy, int document_id) {
+void SearchServer::RemoveDocument(ExecutionPolicy, int document_id) {
     if constexpr (!std::is_same_v<ExecutionPolicy, std::execution::parallel_policy>) {
         RemoveDocument(document_id);
+        return;
     }
     if (documents_.count(document_id) == 0) {
         throw std::invalid_argument("There is no document with this id.");
@@ -329,27 +1052,37 @@ void SearchServer::RemoveDocument(ExecutionPolicy policy, int document_id) {
         throw std::invalid_argument("Invalid document_id");
     }
 
-    const auto &document_to_word_freqs_value = document_to_word_freqs_.find(document_id)->second;
+    const WordFrequenciesView word_frequencies = GetWordFrequencies(document_id);
 
-    std::vector<std::string_view> words(document_to_word_freqs_.at(document_id).size());
+    std::vector<decltype(word_to_document_freqs_)::iterator> word_iters;
+    word_iters.reserve(word_frequencies.size());
+    for (const auto [word, _] : word_frequencies) {
+        word_iters.push_back(word_to_document_freqs_.find(word));
+    }
 
-    transform(std::execution::par,
-              document_to_word_freqs_value.begin(),
-              document_to_word_freqs_value.end(),
-              words.begin(),
-              [](auto& word) {
-                  return word.first;
-              });
+    // у каждого слова свой список документов, их можно менять параллельно; сам словарь - последовательно
+    GetThreadPool().ParallelFor(word_iters.size(), parallel_grain_size_, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            word_iters[i]->second.erase(document_id);
+        }
+    });
 
-    for_each(std::execution::par,
-             words.begin(),
-             words.end(),
-             [&](auto & word) {
-                 word_to_document_freqs_.erase(word_to_document_freqs_.find(word));
-             });
+    for (auto word_iter : word_iters) {
+        RemoveChampionPosting(word_iter->first, word_iter->second, document_id);
+        if (word_iter->second.empty()) {
+            word_to_document_freqs_.erase(word_iter);
+        }
+    }
+    posting_count_ -= word_frequencies.size();
+    forward_index_garbage_ += word_frequencies.size();
+    total_word_count_ -= documents_.at(document_id).word_count;
+    free_ordinals_.push_back(documents_.at(document_id).ordinal);
+    ResetImpacts();
 
     documents_.erase(document_id);
     document_ids_.erase(document_id);
-    document_to_word_freqs_.erase(document_id);
+    if (forward_index_garbage_ * 2 > forward_index_.size()) {
+        CompactForwardIndex();
+    }
 }
 //----------------------------------------------------------------------------------------------------------------------
@@ -0,0 +1,132 @@
+#include "sharded_search_server.h"
+
+#include <algorithm>
+#include <queue>
+#include <utility>
+
+using namespace std;
+
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, string_view stop_words_text)
+        : ShardedSearchServer(shard_count, SplitIntoWords(stop_words_text)) {
+}
+
+void ShardedSearchServer::AddDocument(int document_id, string_view document, DocumentStatus status,
+                                      const vector<int> &ratings) {
+    Shard &shard = GetShard(document_id);
+    unique_lock shard_lock(shard.mutex);
+    shard.server.AddDocument(document_id, document, status, ratings);
+
+    lock_guard statistics_lock(statistics_mutex_);
+    for (const auto [word, frequency]: shard.server.GetWordFrequencies(document_id)) {
+        auto word_iter = document_freqs_.find(word);
+        if (word_iter == document_freqs_.end()) {
+            word_iter = document_freqs_.emplace(string(word), 0).first;
+        }
+        ++word_iter->second;
+    }
+    ++document_count_;
+    total_word_count_ += shard.server.GetDocumentLength(document_id);
+}
+
+void ShardedSearchServer::RemoveDocument(int document_id) {
+    Shard &shard = GetShard(document_id);
+    unique_lock shard_lock(shard.mutex);
+    // слова остаются в словаре шарда и после удаления документа
+    vector<string_view> words;
+    for (const auto [word, frequency]: shard.server.GetWordFrequencies(document_id)) {
+        words.push_back(word);
+    }
+    const uint32_t word_count = shard.server.GetDocumentLength(document_id);
+    shard.server.RemoveDocument(document_id);
+
+    lock_guard statistics_lock(statistics_mutex_);
+    for (string_view word: words) {
+        const auto word_iter = document_freqs_.find(word);
+        if (--word_iter->second == 0) {
+            document_freqs_.erase(word_iter);
+        }
+    }
+    --document_count_;
+    total_word_count_ -= word_count;
+}
+
+int ShardedSearchServer::GetDocumentCount() const {
+    shared_lock lock(statistics_mutex_);
+    return document_count_;
+}
+
+size_t ShardedSearchServer::GetShardCount() const {
+    return shards_.size();
+}
+
+void ShardedSearchServer::SetThreadPool(shared_ptr<ThreadPool> thread_pool) {
+    thread_pool_ = move(thread_pool);
+}
+
+ShardedSearchServer::Shard &ShardedSearchServer::GetShard(int document_id) const {
+    // отрицательный id попадёт в какой-нибудь шард, и тот его отвергнет
+    return *shards_[static_cast<unsigned int>(document_id) % shards_.size()];
+}
+
+ThreadPool &ShardedSearchServer::GetThreadPool() const {
+    return thread_pool_ ? *thread_pool_ : ThreadPool::GetDefault();
+}
+
+CollectionStatistics ShardedSearchServer::GetCollectionStatistics(string_view raw_query) const {
+    CollectionStatistics statistics;
+    for (string_view word: SplitIntoWords(raw_query)) {
+        if (!word.empty() && word[0] == '-') {
+            continue;
+        }
+        if (!word.empty() && word[0] == '+') {
+            word.remove_prefix(1);
+        }
+        statistics.document_freqs.emplace_back(word, 0);
+    }
+    sort(statistics.document_freqs.begin(), statistics.document_freqs.end());
+    statistics.document_freqs.erase(unique(statistics.document_freqs.begin(), statistics.document_freqs.end()),
+                                    statistics.document_freqs.end());
+
+    shared_lock lock(statistics_mutex_);
+    statistics.document_count = document_count_;
+    statistics.average_document_length = document_count_ == 0
+                                         ? 0.0
+                                         : static_cast<double>(total_word_count_) / document_count_;
+    for (auto &[word, document_freq]: statistics.document_freqs) {
+        const auto word_iter = document_freqs_.find(word);
+        if (word_iter != document_freqs_.end()) {
+            document_freq = word_iter->second;
+        }
+    }
+    return statistics;
+}
+
+vector<Document> ShardedSearchServer::MergeTopDocuments(const vector<vector<Document>> &shard_documents) {
+    // куча из текущих лучших документов шардов: (шард, позиция)
+    using Cursor = pair<size_t, size_t>;
+    const auto is_less_relevant = [&shard_documents](const Cursor &lhs, const Cursor &rhs) {
+        return IsMoreRelevant(shard_documents[rhs.first][rhs.second], shard_documents[lhs.first][lhs.second]);
+    };
+    priority_queue<Cursor, vector<Cursor>, decltype(is_less_relevant)> heads(is_less_relevant);
+    for (size_t shard = 0; shard < shard_documents.size(); ++shard) {
+        if (!shard_documents[shard].empty()) {
+            heads.emplace(shard, 0);
+        }
+    }
+
+    vector<Document> result;
+    while (!heads.empty() && result.size() < MAX_RESULT_DOCUMENT_COUNT) {
+        const auto [shard, position] = heads.top();
+        heads.pop();
+        result.push_back(shard_documents[shard][position]);
+        if (position + 1 < shard_documents[shard].size()) {
+            heads.emplace(shard, position + 1);
+        }
+    }
+    return result;
+}
+
+SearchServer::QueryContext &ShardedSearchServer::GetThreadQueryContext() {
+    thread_local SearchServer::QueryContext context;
+    return context;
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "search_server.h"
+
+// Индекс, разбитый на shard_count серверов по document_id % shard_count. Запрос выполняется на всех
+// шардах параллельно (на пуле потоков), лучшие документы шардов сливаются в общий топ.
+// Число документов, средняя длина и частоты слов ведутся по всей коллекции и передаются шардам,
+// поэтому релевантность совпадает с релевантностью одного SearchServer с теми же документами.
+// Добавление и удаление блокируют только свой шард; поиск можно вызывать из нескольких потоков,
+// он разделяемо блокирует статистику на время снимка и каждый шард на время поиска в нём.
+// Документ, добавленный после снимка, ищется с весами из снимка, а слова, которых в снимке нет, пропускаются.
+class ShardedSearchServer {
+public:
+    template<typename StringContainer>
+    ShardedSearchServer(size_t shard_count, const StringContainer &stop_words);
+
+    ShardedSearchServer(size_t shard_count, std::string_view stop_words_text);
+
+    void AddDocument(int document_id, std::string_view document, DocumentStatus status, const std::vector<int> &ratings);
+
+    void RemoveDocument(int document_id);
+    //------------------------------------------------------------------------------------------------------------------
+
+    template<typename RankingModel = TfIdfRanking>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query,
+                                           DocumentStatus status = DocumentStatus::ACTUAL) const;
+
+    template<typename RankingModel = TfIdfRanking, typename DocumentPredicate>
+    std::vector<Document> FindTopDocuments(std::string_view raw_query, DocumentPredicate document_predicate) const;
+    //------------------------------------------------------------------------------------------------------------------
+
+    int GetDocumentCount() const;
+
+    size_t GetShardCount() const;
+
+    // Пул для опроса шардов; по умолчанию ThreadPool::GetDefault()
+    void SetThreadPool(std::shared_ptr<ThreadPool> thread_pool);
+
+private:
+    struct Shard {
+        template<typename StringContainer>
+        explicit Shard(const StringContainer &stop_words) : server(stop_words) {
+        }
+
+        mutable std::shared_mutex mutex;
+        SearchServer server;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::shared_ptr<ThreadPool> thread_pool_;
+
+    // статистика коллекции; блокируется после мьютекса шарда, поиск берёт их по отдельности
+    mutable std::shared_mutex statistics_mutex_;
+    std::map<std::string, size_t, std::less<>> document_freqs_;
+    int document_count_ = 0;
+    uint64_t total_word_count_ = 0;
+
+    Shard &GetShard(int document_id) const;
+
+    ThreadPool &GetThreadPool() const;
+
+    // Снимок статистики для слов запроса; string_view в результате ссылаются на raw_query
+    CollectionStatistics GetCollectionStatistics(std::string_view raw_query) const;
+
+    // Слияние топов шардов, каждый отсортирован по IsMoreRelevant
+    static std::vector<Document> MergeTopDocuments(const std::vector<std::vector<Document>> &shard_documents);
+
+    static SearchServer::QueryContext &GetThreadQueryContext();
+};
+
+template<typename StringContainer>
+ShardedSearchServer::ShardedSearchServer(size_t shard_count, const StringContainer &stop_words) {
+    if (shard_count == 0) {
+        throw std::invalid_argument("Shard count must be positive");
+    }
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<Shard>(stop_words));
+    }
+}
+
+template<typename RankingModel>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query, DocumentStatus status) const {
+    return FindTopDocuments<RankingModel>(raw_query, [status](int, DocumentStatus document_status, int) {
+        return document_status == status;
+    });
+}
+
+template<typename RankingModel, typename DocumentPredicate>
+std::vector<Document> ShardedSearchServer::FindTopDocuments(std::string_view raw_query,
+                                                            DocumentPredicate document_predicate) const {
+    // шарды не блокируются на весь запрос: shared_mutex отдаёт предпочтение читателям, и поток запросов
+    // надолго задержал бы AddDocument и RemoveDocument
+    const CollectionStatistics statistics = GetCollectionStatistics(raw_query);
+
+    std::vector<std::vector<Document>> shard_documents(shards_.size());
+    GetThreadPool().ParallelFor(shards_.size(), 1, [&](size_t begin, size_t end) {
+        SearchServer::QueryContext &context = GetThreadQueryContext();
+        context.SetCollectionStatistics(&statistics);
+        for (size_t i = begin; i < end; ++i) {
+            std::shared_lock lock(shards_[i]->mutex);
+            shard_documents[i] = shards_[i]->server.FindTopDocuments<RankingModel>(context, raw_query, document_predicate);
+        }
+        context.SetCollectionStatistics(nullptr);
+    });
+    return MergeTopDocuments(shard_documents);
+}
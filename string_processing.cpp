@@ -6,6 +6,12 @@ using namespace std;
 
 vector<string_view> SplitIntoWords(string_view text) {
     vector<string_view> words;
+    SplitIntoWords(text, words);
+    return words;
+}
+
+void SplitIntoWords(string_view text, vector<string_view>& words) {
+    words.clear();
 
     while (true) {
         size_t space = text.find(' ');
@@ -17,6 +23,4 @@ vector<string_view> SplitIntoWords(string_view text) {
             text.remove_prefix(space + 1);
         }
     }
-
-    return words;
 }
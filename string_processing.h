@@ -7,6 +7,9 @@
 
 std::vector<std::string_view> SplitIntoWords(std::string_view text);
 
+// То же, но в переданный вектор: его память переиспользуется между вызовами
+void SplitIntoWords(std::string_view text, std::vector<std::string_view>& words);
+
 template <typename StringContainer>
 std::set<std::string, std::less<>> MakeUniqueNonEmptyStrings(StringContainer strings) {
     std::set<std::string, std::less<>> non_empty_strings;
@@ -1,4 +1,15 @@
 #include "test_example_functions.h"
+#include "query_log.h"
+#include "sharded_search_server.h"
+#include "word_filters.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
 
 void TestExamples (SearchServer& search_server) {
 
@@ -7,3 +18,530 @@ void TestExamples (SearchServer& search_server) {
     assertm(word_freq.at("funny"s) == 0.25, "Check the frequency"s);
 
 }
+
+namespace {
+
+// Детерминированный корпус: слова w0..w49, частые слова дают списки длиннее нескольких параллельных диапазонов
+void AddTestCorpus(SearchServer& search_server, int document_count) {
+    uint32_t state = 1;
+    auto next = [&state] {
+        state = state * 1103515245u + 12345u;
+        return (state >> 16) & 0x7FFF;
+    };
+    for (int id = 0; id < document_count; ++id) {
+        string text;
+        for (int i = 0; i < 8; ++i) {
+            // квадрат смещает распределение к первым словам
+            const uint32_t word = next() % 50 * (next() % 50) / 50;
+            text += "w"s + to_string(word) + " "s;
+        }
+        search_server.AddDocument(id * 3, text, id % 7 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL,
+                                  {static_cast<int>(next() % 10)});
+    }
+}
+
+void AssertSameDocuments(const vector<Document>& lhs, const vector<Document>& rhs) {
+    assertm(lhs.size() == rhs.size(), "Same number of documents"s);
+    for (size_t i = 0; i < lhs.size(); ++i) {
+        assertm(lhs[i].id == rhs[i].id, "Same document order"s);
+        assertm(lhs[i].relevance == rhs[i].relevance, "Bit-identical relevance"s);
+        assertm(lhs[i].rating == rhs[i].rating, "Same rating"s);
+    }
+}
+
+// Те же формулы, что у TF-IDF, но списки чемпионов строятся только для TfIdfRanking: поиск идёт по полным спискам
+struct FullListTfIdfRanking : TfIdfRanking {
+};
+
+} // namespace
+
+void TestParallelFindTopDocuments() {
+    SearchServer search_server("w49"s);
+    AddTestCorpus(search_server, 20000);
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+
+    for (const string& query : {"w0 w1 w2"s, "w3 w17 w40 -w1"s, "w0 -w0"s, "w5 w6 w7 w8 w9 w10 w11"s, "w48 w49"s}) {
+        AssertSameDocuments(search_server.FindTopDocuments(query),
+                            search_server.FindTopDocuments(execution::par, query));
+        AssertSameDocuments(search_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(execution::par, query, DocumentStatus::BANNED));
+    }
+}
+
+void TestRequiredWords() {
+    SearchServer search_server("and"s);
+    search_server.AddDocument(1, "cat and dog and bird"s, DocumentStatus::ACTUAL, {1});
+    search_server.AddDocument(2, "cat dog"s, DocumentStatus::ACTUAL, {2});
+    search_server.AddDocument(3, "cat fish"s, DocumentStatus::ACTUAL, {3});
+    search_server.AddDocument(4, "dog fish"s, DocumentStatus::ACTUAL, {4});
+    search_server.AddDocument(5, "cat dog fish bird"s, DocumentStatus::ACTUAL, {5});
+
+    const auto get_ids = [](const vector<Document>& documents) {
+        vector<int> ids;
+        for (const Document& document : documents) {
+            ids.push_back(document.id);
+        }
+        sort(ids.begin(), ids.end());
+        return ids;
+    };
+    assertm(get_ids(search_server.FindTopDocuments("+cat +dog"s)) == vector<int>({1, 2, 5}), "All required words"s);
+    assertm(search_server.FindTopDocuments("+cat +whale dog"s).empty(), "Missing required word matches nothing"s);
+    assertm(get_ids(search_server.FindTopDocuments("+cat bird -fish"s)) == vector<int>({1, 2}),
+            "Minus word excludes documents with the required word"s);
+
+    // остальные слова только добавляют релевантность: результат тот же, что у OR-запроса,
+    // отфильтрованного по обязательному слову
+    const auto has_cat = [&search_server](int document_id, DocumentStatus status, int) {
+        const auto words = search_server.GetWordFrequencies(document_id);
+        return status == DocumentStatus::ACTUAL
+               && any_of(words.begin(), words.end(), [](const auto& word) { return word.word == "cat"sv; });
+    };
+    AssertSameDocuments(search_server.FindTopDocuments("+cat dog bird"s),
+                        search_server.FindTopDocuments("cat dog bird"s, has_cat));
+}
+
+void TestParallelRequiredWords() {
+    SearchServer search_server("w49"s);
+    AddTestCorpus(search_server, 20000);
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+
+    for (const string& query : {"+w0 +w1 w2"s, "+w0 w3 w17 -w2"s, "+w1 +w2 +w3 +w4"s, "+w0 +w48"s}) {
+        AssertSameDocuments(search_server.FindTopDocuments(query),
+                            search_server.FindTopDocuments(execution::par, query));
+    }
+}
+
+void TestRequiredWordsBudget() {
+    SearchServer search_server("w49"s);
+    AddTestCorpus(search_server, 20000);
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+
+    // пересечение идёт по самому короткому обязательному списку; бюджет обрывает его на max_postings-м id
+    vector<int> first_ids;
+    vector<int> second_ids;
+    for (const int document_id : search_server) {
+        for (const auto& word : search_server.GetWordFrequencies(document_id)) {
+            if (word.word == "w0"sv) {
+                first_ids.push_back(document_id);
+            } else if (word.word == "w1"sv) {
+                second_ids.push_back(document_id);
+            }
+        }
+    }
+    const vector<int>& rarest_ids = first_ids.size() < second_ids.size() ? first_ids : second_ids;
+    const string query = "+w0 +w1 w2"s;
+
+    for (const size_t max_postings : {size_t{0}, size_t{1}, size_t{100}}) {
+        // первая позиция самого короткого списка обходится при любом бюджете
+        const int upper_id = rarest_ids[max(max_postings, size_t{1})];
+        const vector<Document> expected = search_server.FindTopDocuments(query, [upper_id](int document_id, DocumentStatus status, int) {
+            return document_id < upper_id && status == DocumentStatus::ACTUAL;
+        });
+        QueryBudget budget;
+        budget.max_postings = max_postings;
+        SearchServer::QueryContext context;
+        context.SetBudget(budget);
+        AssertSameDocuments(search_server.FindTopDocuments(context, query), expected);
+        assertm(!context.GetStats().is_exact, "Cut-off intersection is inexact"s);
+        context.SetBudget(budget);
+        AssertSameDocuments(search_server.FindTopDocuments(execution::par, context, query), expected);
+    }
+
+    QueryBudget budget;
+    budget.max_postings = 0;
+    SearchServer::QueryContext context;
+    context.SetBudget(budget);
+    const auto any_status = [](int, DocumentStatus, int) {
+        return true;
+    };
+    const vector<Document> documents = search_server.FindTopDocuments(context, "+w0"s, any_status);
+    assertm(documents.size() == 1 && documents[0].id == first_ids.front(), "Zero budget finds the first document of the required word"s);
+}
+
+void TestQueryBudget() {
+    SearchServer search_server("w49"s);
+    AddTestCorpus(search_server, 20000);
+    SearchServer::QueryContext context;
+
+    // самое редкое слово обрабатывается, даже если его список длиннее max_postings
+    QueryBudget budget;
+    budget.max_postings = 10;
+    context.SetBudget(budget);
+    assertm(!search_server.FindTopDocuments(context, "w0 w1 w2"s).empty(), "Rarest word is always processed"s);
+    assertm(context.GetStats().processed_term_count == 1 && !context.GetStats().is_exact, "Only the rarest word"s);
+
+    // бюджет действует на один запрос: истёкший срок не переходит на следующие
+    budget = QueryBudget{};
+    budget.deadline = QueryBudget::Clock::now();
+    context.SetBudget(budget);
+    search_server.FindTopDocuments(context, "w0 w1 w2"s);
+    assertm(!context.GetStats().is_exact, "Deadline has passed"s);
+    const vector<Document> documents = search_server.FindTopDocuments(context, "w0 w1 w2"s);
+    assertm(context.GetStats().is_exact, "Budget is reset after a query"s);
+    AssertSameDocuments(documents, search_server.FindTopDocuments("w0 w1 w2"s));
+}
+
+void TestChampionLists() {
+    SearchServer search_server("w49"s);
+    const vector<string> queries = {"w0"s, "w0 w1 w2"s, "w1 w30 w41"s, "w0 w1 -w2"s, "w2 w3 w4 w5 w6"s, "w47 w48"s};
+    const auto check = [&search_server, &queries] {
+        for (const string& query : queries) {
+            AssertSameDocuments(search_server.FindTopDocuments(query),
+                                search_server.FindTopDocuments<FullListTfIdfRanking>(query));
+        }
+    };
+
+    // списки растут и перестраиваются по мере добавления
+    AddTestCorpus(search_server, 20000);
+    check();
+
+    // списки уменьшаются, а у слов, ставших редкими, удаляются
+    for (int id = 0; id < 20000; id += 2) {
+        search_server.RemoveDocument(id * 3);
+    }
+    check();
+    for (int id = 1; id < 20000; id += 4) {
+        search_server.RemoveDocument(id * 3);
+    }
+    check();
+
+    // и появляются снова
+    for (int id = 0; id < 6000; ++id) {
+        search_server.AddDocument(100000 + id, "w0 w1 w1 w2 w"s + to_string(id % 40), DocumentStatus::ACTUAL, {id % 10});
+    }
+    check();
+
+    // долгий срок не мешает пересчитать запрос по полным спискам: результат точный. С бюджетом слова
+    // складываются в другом порядке, поэтому релевантность сравнивается с точностью до последних битов
+    SearchServer::QueryContext context;
+    for (const string& query : queries) {
+        QueryBudget budget;
+        budget.deadline = QueryBudget::Clock::now() + chrono::hours(1);
+        context.SetBudget(budget);
+        const vector<Document> documents = search_server.FindTopDocuments(context, query);
+        assertm(context.GetStats().is_exact, "Budget is not exhausted"s);
+        const vector<Document> expected = search_server.FindTopDocuments(query);
+        assertm(documents.size() == expected.size(), "Same number of documents"s);
+        for (size_t i = 0; i < documents.size(); ++i) {
+            assertm(documents[i].id == expected[i].id, "Same document order"s);
+            assertm(abs(documents[i].relevance - expected[i].relevance) < 1e-12, "Same relevance"s);
+        }
+    }
+}
+
+void TestShardedConcurrentAddAndFind() {
+    // слово, которого нет во внешней статистике (документ добавлен после снимка), пропускается
+    {
+        SearchServer search_server("and"s);
+        search_server.AddDocument(1, "cat and dog"s, DocumentStatus::ACTUAL, {1});
+        search_server.AddDocument(2, "cat new"s, DocumentStatus::ACTUAL, {2});
+        CollectionStatistics statistics;
+        statistics.document_count = 2;
+        statistics.average_document_length = 2.0;
+        statistics.document_freqs = {{"cat"sv, 2}, {"dog"sv, 1}};
+        SearchServer::QueryContext context;
+        context.SetCollectionStatistics(&statistics);
+        assertm(search_server.FindTopDocuments(context, "new"s).empty(), "Word missing from statistics is skipped"s);
+        assertm(search_server.FindTopDocuments(context, "+new cat"s).empty(), "Required word missing from statistics matches nothing"s);
+        const auto documents = search_server.FindTopDocuments<Bm25Ranking>(context, "dog new"s);
+        assertm(documents.size() == 1 && documents[0].id == 1 && isfinite(documents[0].relevance), "Other words are scored"s);
+    }
+
+    constexpr int document_count = 3000;
+    ShardedSearchServer sharded_server(3, "and"sv);
+    sharded_server.SetThreadPool(make_shared<ThreadPool>(2));
+    SearchServer search_server("and"s);
+    const auto get_status = [](int id) {
+        return id % 4 == 0 ? DocumentStatus::BANNED : DocumentStatus::ACTUAL;
+    };
+
+    // каждый документ приносит новое слово, которое ищется сразу после добавления
+    atomic<int> added_count = 0;
+    thread writer([&] {
+        for (int id = 0; id < document_count; ++id) {
+            sharded_server.AddDocument(id, "cat and new"s + to_string(id), get_status(id), {id % 5});
+            added_count.store(id + 1, memory_order_release);
+        }
+    });
+    while (added_count.load(memory_order_acquire) < document_count) {
+        const int last_id = added_count.load(memory_order_acquire);
+        const string query = "cat new"s + to_string(last_id) + " new"s + to_string(last_id + 1);
+        for (const Document& document : sharded_server.FindTopDocuments(query)) {
+            assertm(isfinite(document.relevance), "Relevance is finite during ingest"s);
+        }
+        for (const Document& document : sharded_server.FindTopDocuments<Bm25Ranking>(query, DocumentStatus::BANNED)) {
+            assertm(isfinite(document.relevance), "BM25 relevance is finite during ingest"s);
+        }
+    }
+    writer.join();
+
+    for (int id = 0; id < document_count; ++id) {
+        search_server.AddDocument(id, "cat and new"s + to_string(id), get_status(id), {id % 5});
+    }
+    for (const string& query : {"cat"s, "cat new7"s, "new2999 new0 -cat"s, "new8 new9 new10 new11 new12 new13"s, "+cat new12 new13"s}) {
+        AssertSameDocuments(sharded_server.FindTopDocuments(query), search_server.FindTopDocuments(query));
+        AssertSameDocuments(sharded_server.FindTopDocuments<Bm25Ranking>(query), search_server.FindTopDocuments<Bm25Ranking>(query));
+        AssertSameDocuments(sharded_server.FindTopDocuments(query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments(query, DocumentStatus::BANNED));
+        AssertSameDocuments(sharded_server.FindTopDocuments<Bm25Ranking>(query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments<Bm25Ranking>(query, DocumentStatus::BANNED));
+    }
+}
+
+void TestRankingModels() {
+    {
+        SearchServer search_server(""s);
+        search_server.AddDocument(1, "cat dog"s, DocumentStatus::ACTUAL, {1});
+        search_server.AddDocument(2, "cat cat bird"s, DocumentStatus::ACTUAL, {2});
+        search_server.AddDocument(3, "fish"s, DocumentStatus::ACTUAL, {3});
+
+        // средняя длина 2; вес log((N - df + 0.5) / (df + 0.5) + 1), вклад weight * count * 2.2 / (count + 1.2 * (0.25 + 0.75 * length / 2))
+        const auto dog = search_server.FindTopDocuments<Bm25Ranking>("dog"s);
+        assertm(dog.size() == 1 && dog[0].id == 1, "BM25 finds the only document with the word"s);
+        assertm(abs(dog[0].relevance - 0.9808292530117263) < 1e-12, "BM25 score of a single occurrence"s);
+
+        // в документе 2 слово встречается дважды: число вхождений восстанавливается из доли 1/3 + 1/3
+        const auto cat = search_server.FindTopDocuments<Bm25Ranking>("cat"s);
+        assertm(cat.size() == 2 && cat[0].id == 2 && cat[1].id == 1, "Repeated word ranks higher"s);
+        assertm(abs(cat[0].relevance - 0.5665797174469143) < 1e-12, "BM25 score of a repeated word"s);
+        assertm(abs(cat[1].relevance - 0.47000362924573563) < 1e-12, "BM25 length normalization"s);
+    }
+
+    SearchServer search_server("w49"s);
+    AddTestCorpus(search_server, 20000);
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+    const vector<string> queries = {"w0 w1 w2"s, "w3 w17 w40 -w1"s, "w5 w6 w7 w8 w9 w10 w11"s, "w48 w49"s};
+
+    for (const string& query : queries) {
+        AssertSameDocuments(search_server.FindTopDocuments<Bm25Ranking>(query),
+                            search_server.FindTopDocuments<Bm25Ranking>(execution::par, query));
+        AssertSameDocuments(search_server.FindTopDocuments<Bm25Ranking>(query, DocumentStatus::BANNED),
+                            search_server.FindTopDocuments<Bm25Ranking>(execution::par, query, DocumentStatus::BANNED));
+    }
+
+    const auto find_all = [&search_server, &queries] {
+        vector<vector<Document>> results;
+        for (const string& query : queries) {
+            results.push_back(search_server.FindTopDocuments<Bm25Ranking>(query));
+            results.push_back(search_server.FindTopDocuments<Bm25Ranking>(execution::par, query));
+            results.push_back(search_server.FindTopDocuments<FullListTfIdfRanking>(query));
+        }
+        return results;
+    };
+    const auto assert_same_results = [](const vector<vector<Document>>& lhs, const vector<vector<Document>>& rhs) {
+        assertm(lhs.size() == rhs.size(), "Same number of queries"s);
+        for (size_t i = 0; i < lhs.size(); ++i) {
+            AssertSameDocuments(lhs[i], rhs[i]);
+        }
+    };
+
+    const auto without_impacts = find_all();
+    search_server.PrecomputeImpacts<Bm25Ranking>();
+    assertm(search_server.GetMemoryUsage().impacts > 0, "Impacts are precomputed"s);
+    assert_same_results(without_impacts, find_all());
+
+    search_server.PrecomputeImpacts<FullListTfIdfRanking>();
+    assert_same_results(without_impacts, find_all());
+
+    // новый документ меняет статистику коллекции: старые вклады не годятся
+    search_server.AddDocument(60000, "w0 w1 w2 w3"s, DocumentStatus::ACTUAL, {5});
+    assertm(search_server.GetMemoryUsage().impacts == 0, "AddDocument resets impacts"s);
+    const auto after_add = find_all();
+    search_server.PrecomputeImpacts<Bm25Ranking>();
+    assert_same_results(after_add, find_all());
+
+    search_server.RemoveDocument(60000);
+    assertm(search_server.GetMemoryUsage().impacts == 0, "RemoveDocument resets impacts"s);
+    assert_same_results(without_impacts, find_all());
+}
+
+void TestPredicateException() {
+    const auto throw_on = [](int bad_id) {
+        return [bad_id](int document_id, DocumentStatus, int) {
+            if (document_id == bad_id) {
+                throw runtime_error("Predicate failed"s);
+            }
+            return true;
+        };
+    };
+    {
+        SearchServer search_server(""s);
+        search_server.AddDocument(1, "cat"s, DocumentStatus::ACTUAL, {1});
+        search_server.AddDocument(2, "cat dog"s, DocumentStatus::ACTUAL, {2});
+        search_server.AddDocument(3, "cat dog bird"s, DocumentStatus::ACTUAL, {3});
+
+        bool thrown = false;
+        try {
+            search_server.FindTopDocuments("cat"s, throw_on(3));
+        } catch (const runtime_error&) {
+            thrown = true;
+        }
+        assertm(thrown, "Predicate exception propagates"s);
+        assertm(search_server.FindTopDocuments("cat"s).size() == 3, "Documents touched before the exception are found again"s);
+    }
+
+    SearchServer search_server("w49"s);
+    AddTestCorpus(search_server, 20000);
+    search_server.SetThreadPool(make_shared<ThreadPool>(4));
+    const string query = "w0 w1 w2 -w3"s;
+    const auto expected = search_server.FindTopDocuments<FullListTfIdfRanking>(query);
+
+    for (int bad_id : {0, 30000, 59997}) {
+        bool thrown = false;
+        try {
+            search_server.FindTopDocuments<FullListTfIdfRanking>(execution::par, query, throw_on(bad_id));
+        } catch (const runtime_error&) {
+            thrown = true;
+        }
+        try {
+            search_server.FindTopDocuments<FullListTfIdfRanking>(query, throw_on(bad_id));
+        } catch (const runtime_error&) {
+            thrown = true;
+        }
+        assertm(thrown, "Predicate exception propagates"s);
+        AssertSameDocuments(expected, search_server.FindTopDocuments<FullListTfIdfRanking>(query));
+        AssertSameDocuments(expected, search_server.FindTopDocuments<FullListTfIdfRanking>(execution::par, query));
+    }
+}
+
+void TestWordFilters() {
+    {
+        const StopWordTable empty_table;
+        assertm(!empty_table.Contains(""sv) && !empty_table.Contains("and"sv), "Default table is empty"s);
+        const StopWordTable table(vector<string>{});
+        assertm(!table.Contains(""sv) && !table.Contains("and"sv), "Table without words is empty"s);
+    }
+    {
+        // слова длины 5..9 и отсутствующие слова тех же длин, отличающиеся одним символом
+        vector<string> stop_words;
+        for (int i = 0; i < 50000; ++i) {
+            stop_words.push_back("stop"s + to_string(i));
+        }
+        const StopWordTable table(stop_words);
+        for (int i = 0; i < 50000; ++i) {
+            const string word = "stop"s + to_string(i);
+            assertm(table.Contains(word), "Every stop word is found"s);
+            assertm(!table.Contains("stoq"s + to_string(i)), "Absent word of the same length is rejected"s);
+            assertm(!table.Contains(word.substr(0, word.size() - 1) + "x"s), "Absent word with another last char is rejected"s);
+        }
+        assertm(!table.Contains("stop"sv) && !table.Contains("stop50000"sv), "Absent prefix and next word are rejected"s);
+    }
+    {
+        VocabularyFilter filter;
+        assertm(!filter.MayContain("cat"sv), "Empty filter rejects everything"s);
+        vector<string> words;
+        words.reserve(20000);
+        for (int i = 0; i < 20000; ++i) {
+            words.push_back("word"s + to_string(i));
+            filter.Add(words.back(), words);
+            assertm(filter.MayContain(words.back()), "Added word is accepted"s);
+        }
+        // 20000 слов - несколько перестроений с начальной ёмкости
+        for (const string& word : words) {
+            assertm(filter.MayContain(word), "No false negatives after rebuilds"s);
+        }
+    }
+
+    vector<string> stop_words;
+    for (int i = 0; i < 5000; ++i) {
+        stop_words.push_back("s"s + to_string(i));
+    }
+    SearchServer search_server(stop_words);
+    for (int id = 0; id < 5000; ++id) {
+        search_server.AddDocument(id, "s"s + to_string(id) + " u"s + to_string(id) + " common"s, DocumentStatus::ACTUAL, {1});
+    }
+    for (int id = 0; id < 5000; ++id) {
+        const auto documents = search_server.FindTopDocuments("u"s + to_string(id));
+        assertm(documents.size() == 1 && documents[0].id == id, "Word added before filter rebuilds is found"s);
+        assertm(search_server.FindTopDocuments("s"s + to_string(id)).empty(), "Stop word is not indexed"s);
+    }
+    assertm(search_server.GetDocumentLength(0) == 2, "Stop words are not counted"s);
+}
+
+void TestQueryLog() {
+    const auto assert_error = [](const string& log, const string& message) {
+        istringstream input(log);
+        try {
+            ReadQueryLog(input);
+        } catch (const runtime_error& error) {
+            assertm(error.what() == message, "Expected query log error"s);
+            return;
+        }
+        assertm(false, "Query log error is thrown"s);
+    };
+
+    // длинный запрос - длина в несколько байт varint
+    const vector<QueryLogRecord> expected = {
+            {{}, QueryFilterKind::DEFAULT, DocumentStatus::ACTUAL, "funny pet -rat"s},
+            {{}, QueryFilterKind::STATUS, DocumentStatus::BANNED, "+cat dog"s},
+            {{}, QueryFilterKind::PREDICATE, DocumentStatus::ACTUAL, ""s},
+            {{}, QueryFilterKind::STATUS, DocumentStatus::REMOVED, string(300, 'w')},
+    };
+    ostringstream output;
+    QueryLogWriter writer(output);
+    // конец заголовка и каждой записи: обрезка ровно по ним даёт журнал покороче, а не ошибку
+    vector<size_t> record_ends = {output.str().size()};
+    for (const QueryLogRecord& record : expected) {
+        writer.Write(record.query, record.filter_kind, record.status);
+        record_ends.push_back(output.str().size());
+    }
+    writer.Flush();
+    assertm(writer.GetRecordCount() == expected.size(), "Every record is counted"s);
+    const string log = output.str();
+
+    {
+        istringstream input(log);
+        QueryLogReader reader(input);
+        const auto start_delay = chrono::system_clock::now() - reader.GetStartTime();
+        assertm(start_delay >= 0s && start_delay < 60s, "Start time is the writer creation time"s);
+    }
+    istringstream input(log);
+    const vector<QueryLogRecord> records = ReadQueryLog(input);
+    assertm(records.size() == expected.size(), "Every record is read back"s);
+    for (size_t i = 0; i < records.size(); ++i) {
+        assertm(records[i].query == expected[i].query, "Same query"s);
+        assertm(records[i].filter_kind == expected[i].filter_kind, "Same filter kind"s);
+        assertm(records[i].status == expected[i].status, "Same status"s);
+        assertm(i == 0 || records[i].time >= records[i - 1].time, "Record times do not decrease"s);
+    }
+
+    for (size_t size = record_ends.front() + 1; size < log.size(); ++size) {
+        const auto record_end = find(record_ends.begin(), record_ends.end(), size);
+        if (record_end == record_ends.end()) {
+            assert_error(log.substr(0, size), "Query log is truncated"s);
+        } else {
+            istringstream prefix(log.substr(0, size));
+            assertm(ReadQueryLog(prefix).size() == static_cast<size_t>(record_end - record_ends.begin()),
+                    "Log cut at a record boundary reads the whole records"s);
+        }
+    }
+
+    assert_error(""s, "Not a query log"s);
+    assert_error(log.substr(0, record_ends.front() - 1), "Not a query log"s);
+    assert_error("funny pet and nasty rat"s, "Not a query log"s);
+    string other_version = log;
+    other_version[6] = static_cast<char>(other_version[6] + 1);
+    assert_error(other_version, "Unsupported query log version"s);
+    // вид фильтра за пределами QueryFilterKind
+    assert_error(log.substr(0, record_ends.front()) + "\x00\x03\x00"s, "Query log is corrupted"s);
+}
+
+void TestSearchServer() {
+    {
+        SearchServer search_server("and"s);
+        search_server.AddDocument(1, "funny pet and nasty rat"s, DocumentStatus::ACTUAL, {7, 2, 7});
+        TestExamples(search_server);
+    }
+    TestParallelFindTopDocuments();
+    TestRequiredWords();
+    TestParallelRequiredWords();
+    TestRequiredWordsBudget();
+    TestQueryBudget();
+    TestChampionLists();
+    TestShardedConcurrentAddAndFind();
+    TestRankingModels();
+    TestPredicateException();
+    TestWordFilters();
+    TestQueryLog();
+    cerr << "Search server tests passed"s << endl;
+}
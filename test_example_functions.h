@@ -13,3 +13,41 @@
 using namespace std;
 
 void TestExamples(SearchServer& search_server);
+
+// FindTopDocuments(par) на корпусе из нескольких диапазонов совпадает с последовательным до бита
+void TestParallelFindTopDocuments();
+
+// Обязательные слова ("+"): отсутствующее слово, сочетание с минус-словом, совпадение с отфильтрованным OR-запросом
+void TestRequiredWords();
+
+// Запросы с обязательными словами: par совпадает с последовательной версией до бита
+void TestParallelRequiredWords();
+
+// Бюджет max_postings обрывает пересечение на id, одинаковом для seq и par
+void TestRequiredWordsBudget();
+
+// QueryBudget: самое редкое слово обрабатывается всегда, бюджет действует на один запрос
+void TestQueryBudget();
+
+// Списки чемпионов при добавлении и удалении документов: результат тот же, что по полным спискам, до бита
+void TestChampionLists();
+
+// Поиск по ShardedSearchServer во время добавления документов с новыми словами; после - совпадение с SearchServer до бита
+void TestShardedConcurrentAddAndFind();
+
+// BM25 по формуле на маленьком корпусе; Bm25Ranking par и PrecomputeImpacts совпадают с последовательным поиском до бита,
+// вклады сбрасываются AddDocument/RemoveDocument
+void TestRankingModels();
+
+// Исключение из предиката не оставляет аккумуляторы контекста потока занятыми: следующий запрос находит все документы
+void TestPredicateException();
+
+// StopWordTable: большой и пустой список, отсутствующие слова той же длины; VocabularyFilter без ложных отказов
+// после перестроений, в том числе внутри AddDocument
+void TestWordFilters();
+
+// Журнал запросов: запись и чтение всех видов фильтра, обрезанный и испорченный журнал, чужой заголовок
+void TestQueryLog();
+
+// Все тесты выше; main вызывает их перед замерами
+void TestSearchServer();
@@ -0,0 +1,133 @@
+#include "thread_pool.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+using namespace std;
+
+namespace {
+// очередь текущего потока; задаётся только в потоках пула
+thread_local const ThreadPool* current_pool = nullptr;
+thread_local size_t current_queue_index = 0;
+}
+
+//----------------------------------------------------------------------------------------------------------------------
+ThreadPool::ThreadPool(size_t thread_count, const vector<int>& cpu_ids) {
+    queues_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        queues_.push_back(make_unique<WorkQueue>());
+    }
+    threads_.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        threads_.emplace_back([this, i] { WorkerLoop(i); });
+#ifdef __linux__
+        if (!cpu_ids.empty()) {
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(cpu_ids[i % cpu_ids.size()], &cpu_set);
+            pthread_setaffinity_np(threads_.back().native_handle(), sizeof(cpu_set), &cpu_set);
+        }
+#endif
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard guard(sleep_mutex_);
+        is_stopped_ = true;
+    }
+    wake_up_.notify_all();
+    for (thread& worker : threads_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::GetDefault() {
+    static ThreadPool pool(max(thread::hardware_concurrency(), 1u));
+    return pool;
+}
+
+size_t ThreadPool::GetThreadCount() const {
+    return threads_.size();
+}
+//----------------------------------------------------------------------------------------------------------------------
+void ThreadPool::Submit(function<void()> task) {
+    if (threads_.empty()) {
+        task();
+        return;
+    }
+    const size_t index = GetCurrentQueueIndex();
+    {
+        lock_guard guard(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(move(task));
+    }
+    pending_task_count_.fetch_add(1, memory_order_release);
+    {
+        lock_guard guard(sleep_mutex_);
+    }
+    wake_up_.notify_one();
+}
+
+size_t ThreadPool::GetCurrentQueueIndex() const {
+    if (current_pool == this) {
+        return current_queue_index;
+    }
+    // внешние потоки раскладывают задачи по очередям по кругу
+    return next_queue_.fetch_add(1, memory_order_relaxed) % queues_.size();
+}
+
+bool ThreadPool::TryPopTask(size_t queue_index, bool from_back, function<void()>& task) {
+    WorkQueue& queue = *queues_[queue_index];
+    lock_guard guard(queue.mutex);
+    if (queue.tasks.empty()) {
+        return false;
+    }
+    if (from_back) {
+        task = move(queue.tasks.back());
+        queue.tasks.pop_back();
+    } else {
+        task = move(queue.tasks.front());
+        queue.tasks.pop_front();
+    }
+    pending_task_count_.fetch_sub(1, memory_order_relaxed);
+    return true;
+}
+
+bool ThreadPool::TryRunTask() {
+    if (queues_.empty() || pending_task_count_.load(memory_order_acquire) == 0) {
+        return false;
+    }
+    const bool is_worker = current_pool == this;
+    const size_t own_index = is_worker ? current_queue_index : 0;
+
+    function<void()> task;
+    // свою очередь разбираем с конца (свежие задачи горячие в кэше), чужие - с начала
+    bool has_task = is_worker && TryPopTask(own_index, true, task);
+    for (size_t offset = is_worker ? 1 : 0; !has_task && offset < queues_.size(); ++offset) {
+        has_task = TryPopTask((own_index + offset) % queues_.size(), false, task);
+    }
+    if (!has_task) {
+        return false;
+    }
+    task();
+    return true;
+}
+
+void ThreadPool::WorkerLoop(size_t index) {
+    current_pool = this;
+    current_queue_index = index;
+    while (true) {
+        if (TryRunTask()) {
+            continue;
+        }
+        unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [this] {
+            return is_stopped_ || pending_task_count_.load(memory_order_acquire) > 0;
+        });
+        if (is_stopped_) {
+            return;
+        }
+    }
+}
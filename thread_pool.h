@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Пул потоков с отдельной очередью на каждый поток и кражей задач у соседей.
+// Поток, вызвавший ParallelFor, сам выполняет задачи, пока ждёт завершения,
+// поэтому вложенные вызовы из задач пула не приводят к взаимной блокировке.
+class ThreadPool {
+public:
+    // thread_count == 0 - вся работа выполняется в вызывающем потоке.
+    // cpu_ids - номера процессоров для закрепления потоков (по кругу), пустой - без закрепления
+    explicit ThreadPool(std::size_t thread_count, const std::vector<int>& cpu_ids = {});
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool();
+
+    // Общий пул на процесс, по потоку на ядро; используется, если серверу не задан свой
+    static ThreadPool& GetDefault();
+
+    std::size_t GetThreadCount() const;
+
+    void Submit(std::function<void()> task);
+
+    // Вызывает function(begin, end) для диапазонов [0, count) длиной не больше grain_size
+    // и возвращает управление после обработки всех диапазонов
+    template<typename Function>
+    void ParallelFor(std::size_t count, std::size_t grain_size, Function&& function);
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkQueue>> queues_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleep_mutex_;
+    std::condition_variable wake_up_;
+    std::atomic<std::size_t> pending_task_count_ = 0;
+    mutable std::atomic<std::size_t> next_queue_ = 0;
+    bool is_stopped_ = false;
+
+    void WorkerLoop(std::size_t index);
+
+    bool TryRunTask();
+
+    bool TryPopTask(std::size_t queue_index, bool from_back, std::function<void()>& task);
+
+    std::size_t GetCurrentQueueIndex() const;
+};
+
+template<typename Function>
+void ThreadPool::ParallelFor(std::size_t count, std::size_t grain_size, Function&& function) {
+    if (count == 0) {
+        return;
+    }
+    grain_size = std::max<std::size_t>(grain_size, 1);
+    const std::size_t chunk_count = (count + grain_size - 1) / grain_size;
+    if (threads_.empty() || chunk_count == 1) {
+        function(std::size_t{0}, count);
+        return;
+    }
+
+    std::atomic<std::size_t> remaining = chunk_count;
+    std::mutex exception_mutex;
+    std::exception_ptr exception;
+
+    // первый диапазон выполняется вызывающим потоком, остальные - через очереди
+    auto run_chunk = [&](std::size_t chunk) {
+        try {
+            const std::size_t begin = chunk * grain_size;
+            function(begin, std::min(begin + grain_size, count));
+        } catch (...) {
+            std::lock_guard guard(exception_mutex);
+            if (!exception) {
+                exception = std::current_exception();
+            }
+        }
+        // после последнего диапазона ParallelFor может сразу вернуться, поэтому пул запоминаем заранее
+        ThreadPool *pool = this;
+        if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            {
+                std::lock_guard guard(pool->sleep_mutex_);
+            }
+            pool->wake_up_.notify_all();
+        }
+    };
+    for (std::size_t chunk = 1; chunk < chunk_count; ++chunk) {
+        Submit([&run_chunk, chunk] { run_chunk(chunk); });
+    }
+    run_chunk(0);
+
+    // пока есть чужие задачи, помогаем их выполнять, иначе спим до новой задачи или конца своих диапазонов
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (TryRunTask()) {
+            continue;
+        }
+        std::unique_lock lock(sleep_mutex_);
+        wake_up_.wait(lock, [&] {
+            return remaining.load(std::memory_order_acquire) == 0 || pending_task_count_.load(std::memory_order_acquire) > 0;
+        });
+    }
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+}
@@ -0,0 +1,87 @@
+#include "word_filters.h"
+
+using namespace std;
+
+namespace {
+// в среднем слов на корзину идеального хеша и максимум попыток подобрать сдвиг, прежде чем увеличить таблицу
+constexpr size_t WORDS_PER_BUCKET = 2;
+constexpr uint32_t MAX_DISPLACEMENT_ATTEMPTS = 1 << 16;
+} // namespace
+
+size_t StopWordTable::GetHeapSize() const {
+    return chars_.capacity() + offsets_.capacity() * sizeof(uint32_t) + displacements_.capacity() * sizeof(uint32_t)
+           + slots_.capacity() * sizeof(uint32_t);
+}
+
+void StopWordTable::Build() {
+    const size_t word_count = offsets_.size() - 1;
+    if (word_count == 0) {
+        return;
+    }
+    for (uint32_t i = 0; i < word_count; ++i) {
+        length_mask_ |= LengthBit(GetWord(i).size());
+    }
+    vector<uint64_t> hashes(word_count);
+    for (uint32_t i = 0; i < word_count; ++i) {
+        hashes[i] = HashWord(GetWord(i));
+    }
+
+    displacements_.assign((word_count + WORDS_PER_BUCKET - 1) / WORDS_PER_BUCKET, 0);
+    vector<vector<uint32_t>> buckets(displacements_.size());
+    for (uint32_t i = 0; i < word_count; ++i) {
+        buckets[Bucket(hashes[i])].push_back(i);
+    }
+    // сначала большие корзины, пока таблица пустая
+    vector<size_t> bucket_order(buckets.size());
+    for (size_t bucket = 0; bucket < buckets.size(); ++bucket) {
+        bucket_order[bucket] = bucket;
+    }
+    stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    size_t slot_count = 1;
+    while (slot_count < word_count * 2) {
+        slot_count *= 2;
+    }
+    vector<size_t> bucket_slots;
+    for (bool is_built = false; !is_built; slot_count *= 2) {
+        slots_.assign(slot_count, EMPTY_SLOT);
+        is_built = true;
+        for (size_t bucket : bucket_order) {
+            bool is_placed = false;
+            for (uint32_t displacement = 0; displacement < MAX_DISPLACEMENT_ATTEMPTS && !is_placed; ++displacement) {
+                bucket_slots.clear();
+                is_placed = true;
+                for (uint32_t index : buckets[bucket]) {
+                    const size_t slot = Slot(hashes[index], displacement);
+                    if (slots_[slot] != EMPTY_SLOT || find(bucket_slots.begin(), bucket_slots.end(), slot) != bucket_slots.end()) {
+                        is_placed = false;
+                        break;
+                    }
+                    bucket_slots.push_back(slot);
+                }
+                if (is_placed) {
+                    displacements_[bucket] = displacement;
+                    for (size_t i = 0; i < bucket_slots.size(); ++i) {
+                        slots_[bucket_slots[i]] = buckets[bucket][i];
+                    }
+                }
+            }
+            if (!is_placed) {
+                is_built = false;
+                break;
+            }
+        }
+    }
+}
+
+size_t VocabularyFilter::GetHeapSize() const {
+    return blocks_.capacity() * sizeof(uint64_t);
+}
+
+void VocabularyFilter::Reset(size_t capacity) {
+    capacity_ = capacity;
+    size_ = 0;
+    blocks_.assign((capacity * BLOCK_BITS_PER_WORD + 63) / 64, 0);
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Быстрые отказы до поиска по деревьям: большинство слов запроса - стоп-слова или слова не из индекса.
+
+// перемешивание из splitmix64
+inline uint64_t MixHash(uint64_t hash) {
+    hash ^= hash >> 30;
+    hash *= 0xBF58476D1CE4E5B9ULL;
+    hash ^= hash >> 27;
+    hash *= 0x94D049BB133111EBULL;
+    return hash ^ (hash >> 31);
+}
+
+inline uint64_t HashWord(std::string_view word) {
+    return MixHash(std::hash<std::string_view>{}(word));
+}
+
+// Неизменяемое множество стоп-слов с идеальным хешем (hash-and-displace): проверка - фильтр по длине,
+// один хеш, два чтения из таблиц и одно сравнение строк
+class StopWordTable {
+public:
+    StopWordTable() = default;
+
+    template<typename StringContainer>
+    explicit StopWordTable(const StringContainer &words);
+
+    bool Contains(std::string_view word) const {
+        if ((length_mask_ & LengthBit(word.size())) == 0) {
+            return false;
+        }
+        const uint64_t hash = HashWord(word);
+        const uint32_t index = slots_[Slot(hash, displacements_[Bucket(hash)])];
+        return index != EMPTY_SLOT && GetWord(index) == word;
+    }
+
+    size_t GetHeapSize() const;
+
+private:
+    static constexpr uint32_t EMPTY_SLOT = UINT32_MAX;
+
+    // слова подряд в одном буфере: слово i - [offsets_[i], offsets_[i + 1])
+    std::string chars_;
+    std::vector<uint32_t> offsets_ = {0};
+    // сдвиг хеша для каждой корзины, подобранный так, чтобы слова не сталкивались в slots_
+    std::vector<uint32_t> displacements_;
+    // номер слова по слоту; размер - степень двойки
+    std::vector<uint32_t> slots_;
+    // бит i - есть слово длины i (последний бит - длины от 63)
+    uint64_t length_mask_ = 0;
+
+    static uint64_t LengthBit(size_t length) {
+        return uint64_t{1} << std::min<size_t>(length, 63);
+    }
+
+    size_t Bucket(uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * displacements_.size()) >> 32);
+    }
+
+    size_t Slot(uint64_t hash, uint32_t displacement) const {
+        return static_cast<size_t>(MixHash(hash + displacement)) & (slots_.size() - 1);
+    }
+
+    std::string_view GetWord(uint32_t index) const {
+        return std::string_view(chars_).substr(offsets_[index], offsets_[index + 1] - offsets_[index]);
+    }
+
+    void Build();
+};
+
+// Фильтр Блума по словарю: false - слова точно нет, true - возможно есть.
+// Удалять слова нельзя; удалённые из индекса слова дают только ложные срабатывания.
+class VocabularyFilter {
+public:
+    bool MayContain(std::string_view word) const {
+        if (blocks_.empty()) {
+            return false;
+        }
+        const uint64_t hash = HashWord(word);
+        const uint64_t mask = BlockMask(hash);
+        return (blocks_[BlockIndex(hash)] & mask) == mask;
+    }
+
+    // words - весь словарь вместе с word: по нему фильтр перестраивается вдвое большим, когда заполнится
+    template<typename WordContainer>
+    void Add(std::string_view word, const WordContainer &words);
+
+    size_t GetHeapSize() const;
+
+private:
+    // на слово - три бита в одном 64-битном блоке (одно обращение к памяти на проверку), блоков - по
+    // BLOCK_BITS_PER_WORD бит на слово ёмкости: ложных срабатываний порядка процента
+    static constexpr size_t BLOCK_BITS_PER_WORD = 12;
+    static constexpr size_t MIN_CAPACITY = 1024;
+
+    std::vector<uint64_t> blocks_;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+    static uint64_t BlockMask(uint64_t hash) {
+        return (uint64_t{1} << (hash & 63)) | (uint64_t{1} << ((hash >> 6) & 63)) | (uint64_t{1} << ((hash >> 12) & 63));
+    }
+
+    size_t BlockIndex(uint64_t hash) const {
+        return static_cast<size_t>(((hash >> 32) * blocks_.size()) >> 32);
+    }
+
+    void Insert(std::string_view word) {
+        const uint64_t hash = HashWord(word);
+        blocks_[BlockIndex(hash)] |= BlockMask(hash);
+        ++size_;
+    }
+
+    void Reset(size_t capacity);
+};
+
+template<typename StringContainer>
+StopWordTable::StopWordTable(const StringContainer &words) {
+    std::vector<std::string_view> unique_words(words.begin(), words.end());
+    std::sort(unique_words.begin(), unique_words.end());
+    unique_words.erase(std::unique(unique_words.begin(), unique_words.end()), unique_words.end());
+    for (std::string_view word : unique_words) {
+        chars_.append(word);
+        offsets_.push_back(static_cast<uint32_t>(chars_.size()));
+    }
+    Build();
+}
+
+template<typename WordContainer>
+void VocabularyFilter::Add(std::string_view word, const WordContainer &words) {
+    if (size_ < capacity_) {
+        Insert(word);
+        return;
+    }
+    Reset(std::max({capacity_ * 2, words.size() * 2, MIN_CAPACITY}));
+    for (const auto &vocabulary_word : words) {
+        Insert(vocabulary_word);
+    }
+}